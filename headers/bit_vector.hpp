@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Fixed size bit-vector for dataflow facts numbered 0..size-1
+ * Set operations work a 64 bit word at a time. Union reports whether any bit was added, which is what a
+ * worklist needs to decide whether a successor changed.
+*/
+class BitVector {
+    public:
+
+    BitVector(size_t size = 0) : size_(size), words_((size + 63) / 64, 0) {}
+
+    size_t size() const { return size_; }
+
+    void Set(int i) { words_[i / 64] |= (uint64_t) 1 << (i % 64); }
+
+    void Reset(int i) { words_[i / 64] &= ~((uint64_t) 1 << (i % 64)); }
+
+    bool Test(int i) const { return (words_[i / 64] >> (i % 64)) & 1; }
+
+    /*
+     * this = this U other, returns true if this changed
+     */
+    bool Union(const BitVector& other) {
+        uint64_t added = 0;
+        for (size_t i = 0; i < words_.size(); i++) {
+            added |= other.words_[i] & ~words_[i];
+            words_[i] |= other.words_[i];
+        }
+        return added != 0;
+    }
+
+    // this = this - other
+    void Subtract(const BitVector& other) {
+        for (size_t i = 0; i < words_.size(); i++)
+            words_[i] &= ~other.words_[i];
+    }
+
+    bool Intersects(const BitVector& other) const {
+        for (size_t i = 0; i < words_.size(); i++) {
+            if (words_[i] & other.words_[i])
+                return true;
+        }
+        return false;
+    }
+
+    bool Any() const {
+        for (uint64_t word : words_) {
+            if (word != 0)
+                return true;
+        }
+        return false;
+    }
+
+    /*
+     * Call f on every set bit in increasing order
+     */
+    template <typename F>
+    void ForEach(F f) const {
+        for (size_t i = 0; i < words_.size(); i++) {
+            uint64_t word = words_[i];
+            while (word != 0) {
+                f((int) (i * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    bool operator==(const BitVector& other) const { return words_ == other.words_; }
+    bool operator!=(const BitVector& other) const { return words_ != other.words_; }
+
+    private:
+
+    size_t size_;
+    std::vector<uint64_t> words_;
+};
@@ -53,6 +53,7 @@ class Type {
         int indirection;
         void* ptr_type;
         DataType type;
+        int id = -1; // canonical id in the program's TypeGraph, -1 until one is built
 
         class FunctionType {
             public:
@@ -232,8 +233,12 @@ class Type {
         }
 };
 
+enum class VarScope { Unknown, Global, Param, Local };
+
 /*
  * A variable is a name and a type.
+ * scope and key are resolved once when the program is loaded (see Program::ResolveScopes); key is the name the
+ * points-to analysis and the abstract stores use: the bare name for globals, func.name otherwise.
 */
 class Variable {
     public:
@@ -241,6 +246,12 @@ class Variable {
         Variable(std::string name, Type *type) : name(name), type(type) {};
         std::string name;
         Type *type;
+        VarScope scope = VarScope::Unknown;
+        std::string key;
+
+        bool IsGlobal() const {
+            return scope == VarScope::Global;
+        }
 
         bool isIntType() {
             return (type->indirection == 0 && type->type == DataType::IntType);
@@ -335,6 +346,7 @@ class ExternalFunction {
 
     std::string name;
     Type::FunctionType *funcType;
+    int id = -1; // position in the program's externs, for per-extern tables
 };
 
 /*
@@ -1318,8 +1330,17 @@ class Program {
                     ExternalFunction *ext_func = new ExternalFunction(ext_func_val);
                     ext_funcs[ext_func_key] = ext_func;
                     ext_func->name = ext_func_key;
+                    ext_func->id = ext_funcs.size() - 1;
                 }
             }
+            for (auto global : globals) {
+                global_names.insert(global->globalVar->name);
+                global->globalVar->scope = VarScope::Global;
+                global->globalVar->key = global->globalVar->name;
+            }
+            for (auto &[func_name, func] : funcs) {
+                ResolveScopes(func);
+            }
         };
 
         void print_pretty(json what_to_print) {
@@ -1355,4 +1376,145 @@ class Program {
         std::vector<Global*> globals;
         std::unordered_map<std::string, Function*> funcs;
         std::unordered_map<std::string, ExternalFunction*> ext_funcs;
+        std::unordered_set<std::string> global_names;
+
+        /*
+         * Call f on every variable of func: its parameters, its locals and every variable operand of its
+         * instructions (operands are separate Variable objects from the locals they name)
+         */
+        template <typename F>
+        static void ForEachVariable(Function *func, F f) {
+            auto var = [&](Variable *v) {
+                if (v != nullptr)
+                    f(v);
+            };
+            auto op = [&](Operand *o) {
+                if (o != nullptr && !o->IsConstInt())
+                    f(o->var);
+            };
+            for (auto param : func->params)
+                var(param);
+            for (auto &[local_name, local] : func->locals)
+                var(local);
+            for (auto &[label, bb] : func->bbs) {
+                std::vector<Instruction*> insts = bb->instructions;
+                insts.push_back(bb->terminal);
+                for (auto inst : insts) {
+                    switch (inst->instrType) {
+                        case InstructionType::AddrofInstrType: {
+                            AddrofInstruction *addrof_inst = (AddrofInstruction *) inst;
+                            var(addrof_inst->lhs);
+                            var(addrof_inst->rhs);
+                            break;
+                        }
+                        case InstructionType::AllocInstrType: {
+                            AllocInstruction *alloc_inst = (AllocInstruction *) inst;
+                            var(alloc_inst->lhs);
+                            op(alloc_inst->num);
+                            break;
+                        }
+                        case InstructionType::ArithInstrType: {
+                            ArithInstruction *arith_inst = (ArithInstruction *) inst;
+                            var(arith_inst->lhs);
+                            op(arith_inst->op1);
+                            op(arith_inst->op2);
+                            break;
+                        }
+                        case InstructionType::CmpInstrType: {
+                            CmpInstruction *cmp_inst = (CmpInstruction *) inst;
+                            var(cmp_inst->lhs);
+                            op(cmp_inst->op1);
+                            op(cmp_inst->op2);
+                            break;
+                        }
+                        case InstructionType::CopyInstrType: {
+                            CopyInstruction *copy_inst = (CopyInstruction *) inst;
+                            var(copy_inst->lhs);
+                            op(copy_inst->op);
+                            break;
+                        }
+                        case InstructionType::GepInstrType: {
+                            GepInstruction *gep_inst = (GepInstruction *) inst;
+                            var(gep_inst->lhs);
+                            var(gep_inst->src);
+                            op(gep_inst->idx);
+                            break;
+                        }
+                        case InstructionType::GfpInstrType: {
+                            GfpInstruction *gfp_inst = (GfpInstruction *) inst;
+                            var(gfp_inst->lhs);
+                            var(gfp_inst->src);
+                            break;
+                        }
+                        case InstructionType::LoadInstrType: {
+                            LoadInstruction *load_inst = (LoadInstruction *) inst;
+                            var(load_inst->lhs);
+                            var(load_inst->src);
+                            break;
+                        }
+                        case InstructionType::StoreInstrType: {
+                            StoreInstruction *store_inst = (StoreInstruction *) inst;
+                            var(store_inst->dst);
+                            op(store_inst->op);
+                            break;
+                        }
+                        case InstructionType::CallExtInstrType: {
+                            CallExtInstruction *callext_inst = (CallExtInstruction *) inst;
+                            var(callext_inst->lhs);
+                            for (auto arg : callext_inst->args)
+                                op(arg);
+                            break;
+                        }
+                        case InstructionType::BranchInstrType:
+                            op(((BranchInstruction *) inst)->condition);
+                            break;
+                        case InstructionType::RetInstrType:
+                            op(((RetInstruction *) inst)->op);
+                            break;
+                        case InstructionType::CallDirInstrType: {
+                            CallDirInstruction *calldir_inst = (CallDirInstruction *) inst;
+                            var(calldir_inst->lhs);
+                            for (auto arg : calldir_inst->args)
+                                op(arg);
+                            break;
+                        }
+                        case InstructionType::CallIdrInstrType: {
+                            CallIdrInstruction *callidr_inst = (CallIdrInstruction *) inst;
+                            var(callidr_inst->lhs);
+                            var(callidr_inst->fp);
+                            for (auto arg : callidr_inst->args)
+                                op(arg);
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                }
+            }
+        }
+
+    private:
+        /*
+         * A name is global in func unless func has a local of that name. Every operand is its own Variable, so
+         * each one gets its scope and key here instead of on every lookup.
+         */
+        void Resolve(Function *func, Variable *var) {
+            if (func->locals.count(var->name) == 0 && global_names.count(var->name) > 0) {
+                var->scope = VarScope::Global;
+                var->key = var->name;
+                return;
+            }
+            var->scope = VarScope::Local;
+            for (auto param : func->params) {
+                if (param->name == var->name) {
+                    var->scope = VarScope::Param;
+                    break;
+                }
+            }
+            var->key = func->name + "." + var->name;
+        }
+
+        void ResolveScopes(Function *func) {
+            ForEachVariable(func, [&](Variable *var) { Resolve(func, var); });
+        }
 };
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "bit_vector.hpp"
+
+/*
+ * Reaching definitions as a classical gen/kill problem
+ * A definition is a (program point, variable) pair: a store or a call may define several variables at once, and a
+ * later strong definition of one of them only kills the pair for that variable. Variables and definitions are
+ * numbered densely per function and the store at a program point is a bit-vector over the definitions.
+ *
+ * The DEF/USE sets of every program point are computed once, before the fixpoint, by the analysis using the engine
+ * (reaching-defn and the PDG each have their own GetBlockDefUse). Each block is then summarized by the definitions
+ * it generates and kills, so a worklist visit is OUT = GEN U (IN - KILL) whatever the size of the block, and the
+ * per program point solution is only materialized by the final pass over the blocks.
+*/
+class DefTable {
+    public:
+
+    int Var(const std::string &name) {
+        auto it = var_ids.find(name);
+        if (it != var_ids.end())
+            return it->second;
+        var_ids[name] = var_defs.size();
+        var_defs.push_back({});
+        return var_defs.size() - 1;
+    }
+
+    // Definition of var at pp
+    int Def(const std::string &pp, int var) {
+        auto key = std::make_pair(pp, var);
+        auto it = def_ids.find(key);
+        if (it != def_ids.end())
+            return it->second;
+        def_ids[key] = def_pps.size();
+        def_pps.push_back(pp);
+        var_defs[var].push_back(def_pps.size() - 1);
+        return def_pps.size() - 1;
+    }
+
+    int NumDefs() const { return def_pps.size(); }
+
+    const std::string &DefPP(int def) const { return def_pps[def]; }
+
+    /*
+     * Build the per variable masks of definitions, once every definition is numbered
+     */
+    void Finalize() {
+        var_masks.assign(var_defs.size(), BitVector(NumDefs()));
+        for (int var = 0; var < var_defs.size(); var++) {
+            for (int def : var_defs[var])
+                var_masks[var].Set(def);
+        }
+    }
+
+    const std::vector<int> &VarDefs(int var) const { return var_defs[var]; }
+
+    // All definitions of var
+    const BitVector &VarMask(int var) const { return var_masks[var]; }
+
+    private:
+
+    std::unordered_map<std::string, int> var_ids;
+    std::map<std::pair<std::string, int>, int> def_ids;
+    std::vector<std::string> def_pps;       // definition -> program point
+    std::vector<std::vector<int>> var_defs; // variable -> its definitions
+    std::vector<BitVector> var_masks;
+};
+
+/*
+ * Uses and definitions of one program point
+ * Weak definitions are applied before strong ones (sigma'[v] = sigma'[v] U { pp }, then sigma'[x] = { pp }).
+ */
+struct DefUse {
+    std::string pp;
+    std::vector<int> uses;                          // variables
+    std::vector<std::pair<int, int>> weak_defs;     // (variable, definition)
+    std::vector<std::pair<int, int>> strong_defs;   // (variable, definition)
+};
+
+struct BlockDefUse {
+    std::string label;
+    std::vector<DefUse> pps;         // instructions, then the terminal
+    std::vector<std::string> succs;
+    BitVector gen;
+    BitVector kill;
+};
+
+/*
+ * Apply the definitions of one program point to the store
+ */
+void ApplyDefs(const DefUse &du, BitVector &store, const DefTable &defs) {
+    for (auto [var, def] : du.weak_defs)
+        store.Set(def);
+    for (auto [var, def] : du.strong_defs) {
+        store.Subtract(defs.VarMask(var));
+        store.Set(def);
+    }
+}
+
+/*
+ * GEN and KILL of a block, composed from its program points in order
+ */
+void SummarizeBlock(BlockDefUse &block, const DefTable &defs) {
+    block.gen = BitVector(defs.NumDefs());
+    block.kill = BitVector(defs.NumDefs());
+    for (const DefUse &du : block.pps) {
+        ApplyDefs(du, block.gen, defs);
+        for (auto [var, def] : du.strong_defs)
+            block.kill.Union(defs.VarMask(var));
+    }
+}
+
+/*
+ * Transfer function of a block: OUT = GEN U (IN - KILL); joins OUT into the successors and queues the ones that
+ * changed or were never visited
+ */
+void execute(
+    const BlockDefUse &block,
+    std::map<std::string, BitVector> &bb2store,
+    std::deque<std::string> &worklist,
+    std::set<std::string> &bbs_to_output,
+    const DefTable &defs
+)
+{
+    BitVector out = bb2store.at(block.label);
+    out.Subtract(block.kill);
+    out.Union(block.gen);
+
+    for (const std::string &succ : block.succs) {
+        auto [it, inserted] = bb2store.try_emplace(succ, defs.NumDefs());
+        bool store_changed = it->second.Union(out);
+        if (store_changed || bbs_to_output.count(succ) == 0) {
+            worklist.push_back(succ);
+            bbs_to_output.insert(succ);
+        }
+    }
+}
+
+/*
+ * Final pass over a block: soln[pp] = soln[pp] U sigma_prime[v] for all v in USE of every program point
+ */
+void execute_final(
+    const BlockDefUse &block,
+    const BitVector &in,
+    std::map<std::string, std::set<std::string>> &soln,
+    const DefTable &defs
+)
+{
+    BitVector sigma_prime = in;
+    for (const DefUse &du : block.pps) {
+        if (!du.uses.empty()) {
+            std::set<std::string> &reaching = soln[du.pp];
+            for (int var : du.uses) {
+                for (int def : defs.VarDefs(var)) {
+                    if (sigma_prime.Test(def))
+                        reaching.insert(defs.DefPP(def));
+                }
+            }
+        }
+        ApplyDefs(du, sigma_prime, defs);
+    }
+}
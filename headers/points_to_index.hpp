@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Read-only view of a points-to solution shared by the taint analysis, ModRef and ReachingDef.
+ * Every name (pointer variable or abstract location) is given an integer ID, and the points-to sets are
+ * stored in CSR form: the targets of variable v are targets_[offsets_[v] .. offsets_[v + 1]), sorted by
+ * name so that iterating them visits the same names in the same order as the std::set they were built from.
+ * The index is built once and then only passed around by const reference.
+ *
+ * The index also holds the reachability closure of the points-to graph (every location reachable from a
+ * variable through one or more points-to edges). It is computed once on the SCC condensation of the graph:
+ * SCCs are processed in reverse topological order, so the closure of an SCC is the union of its successors'
+ * members and closures, and all members of an SCC share one closure.
+ */
+class PointsToIndex {
+    public:
+
+    /*
+     * The targets of a single variable; iterating yields the names of the abstract locations
+     */
+    class Targets {
+        public:
+        class iterator {
+            public:
+            iterator(const PointsToIndex* index, const int* pos) : index_(index), pos_(pos) {}
+            const std::string& operator*() const { return index_->Name(*pos_); }
+            iterator& operator++() { ++pos_; return *this; }
+            bool operator!=(const iterator& other) const { return pos_ != other.pos_; }
+            bool operator==(const iterator& other) const { return pos_ == other.pos_; }
+            private:
+            const PointsToIndex* index_;
+            const int* pos_;
+        };
+
+        Targets(const PointsToIndex* index, const int* begin, const int* end) : index_(index), begin_(begin), end_(end) {}
+        iterator begin() const { return iterator(index_, begin_); }
+        iterator end() const { return iterator(index_, end_); }
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+        const int* id_begin() const { return begin_; }
+        const int* id_end() const { return end_; }
+
+        private:
+        const PointsToIndex* index_;
+        const int* begin_;
+        const int* end_;
+    };
+
+    PointsToIndex() : offsets_(1, 0), reach_offsets_(1, 0) {}
+
+    template <typename Solution>
+    explicit PointsToIndex(const Solution& solution) {
+        // Number the names in sorted order so that sorting targets by ID also sorts them by name
+        std::set<std::string> all_names;
+        for (const auto& [var, targets] : solution) {
+            all_names.insert(var);
+            all_names.insert(targets.begin(), targets.end());
+        }
+        names_.assign(all_names.begin(), all_names.end());
+        ids_.reserve(names_.size());
+        for (int id = 0; id < names_.size(); id++) {
+            ids_[names_[id]] = id;
+        }
+
+        has_entry_.assign(names_.size(), false);
+        std::vector<std::vector<int>> targets_of(names_.size());
+        for (const auto& [var, targets] : solution) {
+            int var_id = ids_.at(var);
+            has_entry_[var_id] = true;
+            for (const auto& target : targets) {
+                targets_of[var_id].push_back(ids_.at(target));
+            }
+        }
+
+        offsets_.assign(names_.size() + 1, 0);
+        for (int id = 0; id < names_.size(); id++) {
+            std::sort(targets_of[id].begin(), targets_of[id].end());
+            offsets_[id + 1] = offsets_[id] + targets_of[id].size();
+        }
+        targets_.reserve(offsets_.back());
+        for (const auto& targets : targets_of) {
+            targets_.insert(targets_.end(), targets.begin(), targets.end());
+        }
+
+        ComputeReachability();
+    }
+
+    /*
+     * ID of a name, or -1 if the name doesn't appear in the solution
+     */
+    int GetId(const std::string& name) const {
+        auto it = ids_.find(name);
+        return it == ids_.end() ? -1 : it->second;
+    }
+
+    const std::string& Name(int id) const { return names_[id]; }
+
+    int NumNames() const { return names_.size(); }
+
+    /*
+     * True if the solution has an entry for var, like std::map::count
+     */
+    bool Contains(const std::string& var) const {
+        int id = GetId(var);
+        return id >= 0 && has_entry_[id];
+    }
+
+    Targets PointsTo(int var_id) const {
+        if (var_id < 0) {
+            return Targets(this, nullptr, nullptr);
+        }
+        return Targets(this, targets_.data() + offsets_[var_id], targets_.data() + offsets_[var_id + 1]);
+    }
+
+    Targets PointsTo(const std::string& var) const { return PointsTo(GetId(var)); }
+
+    /*
+     * All locations reachable from var through one or more points-to edges, sorted by name
+     */
+    Targets Reachable(int var_id) const {
+        if (var_id < 0) {
+            return Targets(this, nullptr, nullptr);
+        }
+        int scc = scc_of_[var_id];
+        return Targets(this, reach_targets_.data() + reach_offsets_[scc], reach_targets_.data() + reach_offsets_[scc + 1]);
+    }
+
+    Targets Reachable(const std::string& var) const { return Reachable(GetId(var)); }
+
+    /*
+     * Union of the locations reachable from each of the variables, as sorted name IDs
+     * Merges the memoized closures, so a query costs the size of its result rather than the number of names.
+     */
+    std::vector<int> Reachable(const std::vector<int>& var_ids) const {
+        std::vector<int> reachable;
+        for (int var_id : var_ids) {
+            Targets closure = Reachable(var_id);
+            size_t mid = reachable.size();
+            reachable.insert(reachable.end(), closure.id_begin(), closure.id_end());
+            std::inplace_merge(reachable.begin(), reachable.begin() + mid, reachable.end());
+        }
+        reachable.erase(std::unique(reachable.begin(), reachable.end()), reachable.end());
+        return reachable;
+    }
+
+    private:
+
+    /*
+     * Tarjan's algorithm (iterative) over the points-to graph followed by the closure of every SCC
+     * Tarjan numbers the SCCs in reverse topological order, i.e. every edge leaving an SCC goes to an SCC with a
+     * smaller number, so processing SCCs in increasing order sees the closures of all successors first.
+     */
+    void ComputeReachability() {
+        int n = names_.size();
+        std::vector<int> index(n, -1), low(n, 0), stack;
+        std::vector<bool> on_stack(n, false);
+        std::vector<std::pair<int, int>> call_stack; // (node, position of the next edge to visit)
+        int next_index = 0, num_sccs = 0;
+        scc_of_.assign(n, -1);
+
+        for (int root = 0; root < n; root++) {
+            if (index[root] != -1)
+                continue;
+            index[root] = low[root] = next_index++;
+            stack.push_back(root);
+            on_stack[root] = true;
+            call_stack.push_back({root, offsets_[root]});
+
+            while (!call_stack.empty()) {
+                int v = call_stack.back().first;
+                int pos = call_stack.back().second;
+                if (pos < offsets_[v + 1]) {
+                    call_stack.back().second++;
+                    int w = targets_[pos];
+                    if (index[w] == -1) {
+                        index[w] = low[w] = next_index++;
+                        stack.push_back(w);
+                        on_stack[w] = true;
+                        call_stack.push_back({w, offsets_[w]});
+                    }
+                    else if (on_stack[w]) {
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+
+                if (low[v] == index[v]) {
+                    int w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        on_stack[w] = false;
+                        scc_of_[w] = num_sccs;
+                    } while (w != v);
+                    num_sccs++;
+                }
+                call_stack.pop_back();
+                if (!call_stack.empty()) {
+                    int parent = call_stack.back().first;
+                    low[parent] = std::min(low[parent], low[v]);
+                }
+            }
+        }
+
+        std::vector<std::vector<int>> members(num_sccs);
+        for (int v = 0; v < n; v++) {
+            members[scc_of_[v]].push_back(v);
+        }
+
+        // Closure of each SCC: every target of a member plus the closure of the target's SCC
+        std::vector<bool> in_closure(n, false);
+        std::vector<int> closure;
+        reach_offsets_.assign(num_sccs + 1, 0);
+        for (int scc = 0; scc < num_sccs; scc++) {
+            closure.clear();
+            auto add = [&](int loc) {
+                if (!in_closure[loc]) {
+                    in_closure[loc] = true;
+                    closure.push_back(loc);
+                }
+            };
+            for (int v : members[scc]) {
+                for (int pos = offsets_[v]; pos < offsets_[v + 1]; pos++) {
+                    int w = targets_[pos];
+                    add(w);
+                    int target_scc = scc_of_[w];
+                    if (target_scc != scc) {
+                        for (int r = reach_offsets_[target_scc]; r < reach_offsets_[target_scc + 1]; r++) {
+                            add(reach_targets_[r]);
+                        }
+                    }
+                }
+            }
+            std::sort(closure.begin(), closure.end());
+            for (int loc : closure) {
+                in_closure[loc] = false;
+            }
+            reach_targets_.insert(reach_targets_.end(), closure.begin(), closure.end());
+            reach_offsets_[scc + 1] = reach_targets_.size();
+        }
+    }
+
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, int> ids_;
+    std::vector<bool> has_entry_;
+    std::vector<int> offsets_;
+    std::vector<int> targets_;
+
+    // SCC of every name and the closure of every SCC in CSR form
+    std::vector<int> scc_of_;
+    std::vector<int> reach_offsets_;
+    std::vector<int> reach_targets_;
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "./datatypes.h"
+#include "./bit_vector.hpp"
+
+/*
+ * Canonical type graph of a program
+ * Every Type in the IR is its own object, so types are hash-consed on a structural key: ints by indirection,
+ * structs by name and indirection, functions by signature and indirection. The constructor interns the type of
+ * every variable and struct field and stores the canonical id on the Type itself, so looking up the id of a
+ * variable's type afterwards is a field read.
+ *
+ * Edges follow what a value of a type can reach: a pointer (other than a function pointer) reaches its pointee
+ * and a struct reaches its fields. The reachable types of a type are everything reachable over one or more edges,
+ * except struct values, which are reached only for their fields. They are computed once per SCC of the graph
+ * here, so the analyses only union precomputed sets, and the graph is read-only after construction.
+ *
+ * The canonical types and the fake variables are owned by the graph.
+*/
+class TypeGraph {
+    public:
+
+    TypeGraph(Program *program) : program_(program) {
+        for (auto gl : program->globals)
+            Intern(gl->globalVar->type);
+        for (auto &[func_name, func] : program->funcs)
+            Program::ForEachVariable(func, [&](Variable *var) { Intern(var->type); });
+        for (auto &[struct_name, st] : program->structs) {
+            for (auto field : st->fields)
+                Intern(field->type);
+        }
+
+        // Interning pointees and fields can add types, which need edges of their own
+        for (int id = 0; id < types_.size(); id++)
+            AddEdges(id);
+
+        ComputeReachable();
+
+        empty_ = BitVector(types_.size());
+        globals_reachable_ = BitVector(types_.size());
+        for (auto gl : program->globals)
+            globals_reachable_.Union(Reachable(gl->globalVar->type));
+
+        for (int id = 0; id < types_.size(); id++)
+            fakes_.push_back(std::make_unique<Variable>("fake_var_" + std::to_string(id), types_[id].get()));
+    }
+
+    size_t size() const { return types_.size(); }
+
+    /*
+     * Canonical id of type, -1 if no type of the program has its structure
+     */
+    int Id(const Type *type) const {
+        if (type->id >= 0)
+            return type->id;
+        auto it = ids_.find(Key(type));
+        return it == ids_.end() ? -1 : it->second;
+    }
+
+    const BitVector& Reachable(int id) const {
+        return reachable_[scc_of_[id]];
+    }
+
+    const BitVector& Reachable(const Type *type) const {
+        int id = Id(type);
+        return id < 0 ? empty_ : Reachable(id);
+    }
+
+    // Types reachable from any global
+    const BitVector& GlobalsReachable() const {
+        return globals_reachable_;
+    }
+
+    /*
+     * A variable standing for the unnamed objects of type id, shared by every analysis of the program
+     */
+    Variable* Fake(int id) const {
+        return fakes_[id].get();
+    }
+
+    private:
+
+    static std::string Key(const Type *type) {
+        std::string key(type->indirection, '&');
+        switch (type->type) {
+            case DataType::IntType:
+                return key + "int";
+            case DataType::StructType:
+                return key + "struct " + ((Type::StructType *) type->ptr_type)->name;
+            case DataType::FuncType: {
+                Type::FunctionType *func_type = (Type::FunctionType *) type->ptr_type;
+                key += "fn(";
+                for (int i = 0; i < func_type->params.size(); i++)
+                    key += (i > 0 ? "," : "") + Key(func_type->params[i]);
+                return key + ")->" + (func_type->ret != nullptr ? Key(func_type->ret) : "void");
+            }
+        }
+        return key;
+    }
+
+    int Intern(DataType data_type, void *ptr_type, int indirection) {
+        Type type;
+        type.type = data_type;
+        type.ptr_type = ptr_type;
+        type.indirection = indirection;
+        return Intern(&type);
+    }
+
+    int Intern(Type *type) {
+        if (type->id >= 0)
+            return type->id;
+        auto [it, inserted] = ids_.try_emplace(Key(type), types_.size());
+        if (inserted) {
+            auto canonical = std::make_unique<Type>();
+            canonical->type = type->type;
+            canonical->ptr_type = type->ptr_type;
+            canonical->indirection = type->indirection;
+            canonical->id = it->second;
+            types_.push_back(std::move(canonical));
+            succs_.emplace_back();
+        }
+        type->id = it->second;
+        return it->second;
+    }
+
+    void AddEdges(int id) {
+        Type *type = types_[id].get();
+        if (type->indirection > 0 && !(type->indirection == 1 && type->type == DataType::FuncType)) {
+            int pointee = Intern(type->type, type->ptr_type, type->indirection - 1);
+            succs_[id].push_back(pointee);
+        }
+        else if (type->type == DataType::StructType) {
+            auto st = program_->structs.find(((Type::StructType *) type->ptr_type)->name);
+            if (st == program_->structs.end())
+                return;
+            for (auto field : st->second->fields) {
+                int field_id = Intern(field->type);
+                succs_[id].push_back(field_id);
+            }
+        }
+    }
+
+    bool IsStructValue(int id) const {
+        return types_[id]->type == DataType::StructType && types_[id]->indirection == 0;
+    }
+
+    /*
+     * Tarjan's algorithm (iterative) over the type graph followed by the reachable set of every SCC, as in
+     * PointsToIndex::ComputeReachability: SCCs are numbered in reverse topological order, so processing them in
+     * increasing order sees the sets of all successors first.
+     */
+    void ComputeReachable() {
+        int n = types_.size();
+        std::vector<int> index(n, -1), low(n, 0), stack;
+        std::vector<bool> on_stack(n, false);
+        std::vector<std::pair<int, int>> call_stack; // (type, position of the next edge to visit)
+        int next_index = 0, num_sccs = 0;
+        scc_of_.assign(n, -1);
+
+        for (int root = 0; root < n; root++) {
+            if (index[root] != -1)
+                continue;
+            index[root] = low[root] = next_index++;
+            stack.push_back(root);
+            on_stack[root] = true;
+            call_stack.push_back({root, 0});
+
+            while (!call_stack.empty()) {
+                int v = call_stack.back().first;
+                int pos = call_stack.back().second;
+                if (pos < succs_[v].size()) {
+                    call_stack.back().second++;
+                    int w = succs_[v][pos];
+                    if (index[w] == -1) {
+                        index[w] = low[w] = next_index++;
+                        stack.push_back(w);
+                        on_stack[w] = true;
+                        call_stack.push_back({w, 0});
+                    }
+                    else if (on_stack[w]) {
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+
+                if (low[v] == index[v]) {
+                    int w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        on_stack[w] = false;
+                        scc_of_[w] = num_sccs;
+                    } while (w != v);
+                    num_sccs++;
+                }
+                call_stack.pop_back();
+                if (!call_stack.empty()) {
+                    int parent = call_stack.back().first;
+                    low[parent] = std::min(low[parent], low[v]);
+                }
+            }
+        }
+
+        std::vector<std::vector<int>> members(num_sccs);
+        for (int v = 0; v < n; v++)
+            members[scc_of_[v]].push_back(v);
+
+        // Every successor of a member, except struct values, plus the reachable set of the successor's SCC
+        reachable_.assign(num_sccs, BitVector(n));
+        for (int scc = 0; scc < num_sccs; scc++) {
+            for (int v : members[scc]) {
+                for (int w : succs_[v]) {
+                    if (!IsStructValue(w))
+                        reachable_[scc].Set(w);
+                    if (scc_of_[w] != scc)
+                        reachable_[scc].Union(reachable_[scc_of_[w]]);
+                }
+            }
+        }
+    }
+
+    Program *program_;
+    std::vector<std::unique_ptr<Type>> types_;   // id -> canonical type
+    std::unordered_map<std::string, int> ids_;   // structural key -> id
+    std::vector<std::vector<int>> succs_;        // id -> pointee or field types
+    std::vector<int> scc_of_;                    // id -> SCC of the type graph
+    std::vector<BitVector> reachable_;           // SCC -> reachable types
+    BitVector globals_reachable_;
+    BitVector empty_;
+    std::vector<std::unique_ptr<Variable>> fakes_;
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/*
+* Tokens of the set constraint input format
+* e.g. ref(_alloc1,_alloc1) <= f1._t6
+*      main._t7 <= lam_[(&&int,&int)->&int](_DUMMY,main._t8,main._t3,main.id2)
+*      proj(ref,1,f1._t1) <= f1._t2
+*/
+enum class TokenKind {
+    Ident,      // set variable, constructor name, constant name, type or projection index
+    LParen,     // (
+    RParen,     // )
+    LBracket,   // [
+    RBracket,   // ]
+    Comma,      // ,
+    Le,         // <=
+    Arrow,      // ->
+    Newline,    // end of a constraint
+    End         // end of input
+};
+
+struct Token {
+    TokenKind kind;
+    std::string_view text;
+};
+
+/*
+* Single pass lexer over a memory mapped constraint file
+* Tokens are string_views into the mapped buffer, so no token is ever copied. The buffer stays mapped
+* for the lifetime of the lexer, which lets the solver key its set variable table on the views directly.
+*/
+class ConstraintLexer {
+    public:
+
+    ConstraintLexer(const char* path) {
+        fd_ = open(path, O_RDONLY);
+        if (fd_ < 0)
+            return;
+        struct stat st;
+        if (fstat(fd_, &st) == 0 && st.st_size > 0) {
+            void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = (const char*) mapped;
+                size_ = st.st_size;
+                madvise(mapped, size_, MADV_SEQUENTIAL);
+            }
+        }
+        pos_ = data_;
+        Advance();
+    }
+
+    ~ConstraintLexer() {
+        if (data_ != nullptr)
+            munmap((void*) data_, size_);
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    ConstraintLexer(const ConstraintLexer&) = delete;
+    ConstraintLexer& operator=(const ConstraintLexer&) = delete;
+
+    // False if the file could not be opened
+    bool IsOpen() const { return fd_ >= 0; }
+
+    const Token& Peek() const { return current_; }
+
+    Token Next() {
+        Token token = current_;
+        Advance();
+        return token;
+    }
+
+    bool AtEnd() const { return current_.kind == TokenKind::End; }
+
+    /*
+    * Consume the next token if it is of the given kind
+    */
+    bool Accept(TokenKind kind) {
+        if (current_.kind != kind)
+            return false;
+        Advance();
+        return true;
+    }
+
+    /*
+    * Consume a token of the given kind, reporting a mismatch the same way util::Tokenizer::ConsumeToken does
+    * A mismatch leaves the token in place and marks the current constraint as failed; only the first mismatch of a
+    * constraint is reported, the caller recovers with SkipLine.
+    */
+    void Expect(TokenKind kind, const char* expected) {
+        if (current_.kind == TokenKind::End || failed_)
+            return;
+        if (current_.kind != kind) {
+            Fail(expected);
+            return;
+        }
+        Advance();
+    }
+
+    void Fail(const char* expected) {
+        if (failed_)
+            return;
+        std::cout << "Expected " << expected << " but got " << current_.text << std::endl;
+        failed_ = true;
+    }
+
+    std::string_view ExpectIdent() {
+        if (current_.kind != TokenKind::Ident) {
+            Expect(TokenKind::Ident, "identifier");
+            return {};
+        }
+        return Next().text;
+    }
+
+    // True if a token didn't match since the last SkipLine
+    bool Failed() const { return failed_; }
+
+    /*
+    * Drop the rest of the current line, including its newline, and clear the failure
+    */
+    void SkipLine() {
+        while (current_.kind != TokenKind::Newline && current_.kind != TokenKind::End)
+            Advance();
+        Accept(TokenKind::Newline);
+        failed_ = false;
+    }
+
+    private:
+
+    static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    static bool IsDelimiter(const char* p, const char* end) {
+        char c = *p;
+        if (c == '(' || c == ')' || c == '[' || c == ']' || c == ',' || c == '\n' || IsSpace(c))
+            return true;
+        if (p + 1 < end && ((c == '<' && p[1] == '=') || (c == '-' && p[1] == '>')))
+            return true;
+        return false;
+    }
+
+    void Advance() {
+        const char* end = data_ + size_;
+        while (pos_ < end && IsSpace(*pos_))
+            pos_++;
+
+        if (pos_ >= end) {
+            current_ = {TokenKind::End, {}};
+            return;
+        }
+
+        const char* start = pos_;
+        TokenKind kind = TokenKind::Ident;
+        switch (*pos_) {
+            case '(': kind = TokenKind::LParen; break;
+            case ')': kind = TokenKind::RParen; break;
+            case '[': kind = TokenKind::LBracket; break;
+            case ']': kind = TokenKind::RBracket; break;
+            case ',': kind = TokenKind::Comma; break;
+            case '\n': kind = TokenKind::Newline; break;
+            default: break;
+        }
+
+        if (kind != TokenKind::Ident) {
+            pos_++;
+        }
+        else if (pos_ + 1 < end && pos_[0] == '<' && pos_[1] == '=') {
+            kind = TokenKind::Le;
+            pos_ += 2;
+        }
+        else if (pos_ + 1 < end && pos_[0] == '-' && pos_[1] == '>') {
+            kind = TokenKind::Arrow;
+            pos_ += 2;
+        }
+        else {
+            while (pos_ < end && !IsDelimiter(pos_, end))
+                pos_++;
+        }
+        current_ = {kind, std::string_view(start, pos_ - start)};
+    }
+
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const char* pos_ = nullptr;
+    Token current_ = {TokenKind::End, {}};
+    bool failed_ = false;
+};
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include "./set_constraint_util.cpp"
+#include "./worklist.hpp"
+
+/*
+* Set constraint solver core: the constraint graph, AddEdge and Solve
+* The graph is built either by parsing a constraint file (constraint_solver.cpp) or directly from generated
+* statements (points_to_pipeline.hpp). The state is global, so a process solves a single constraint system.
+*/
+namespace pta {
+
+// Set variables indexed by id, and the name -> set variable table used while parsing
+std::vector<Node*> set_vars;
+std::unordered_map<std::string_view, Node*> set_var_map;
+
+Worklist worklist;
+
+// Field objects created by offset projections keyed by (object, offset)
+std::map<std::pair<std::string, int>, Node*> field_refs;
+
+// Storage for set variable names that don't point into a mapped constraint file
+std::deque<std::string> owned_names;
+
+// Number of successor edges added so far, lets the TOPO policy skip recomputing an order that can't have changed
+long num_successor_edges = 0;
+
+/*
+* AddEdge adds an edge between two nodes in the graph
+* The rules for determining whether it should be stored as a successor or predecessor edge are:
+* 1. Any edge where the lhs is a constructor call is a predecessor edge
+    1.a. If the rhs is a constructor call, add an edge between each corresponding argument
+* 2. Any edge where the rhs is a projection is a predecessor edge
+* 3. Any other edge is a successor edge
+*/
+void AddEdge(Node* lhs, Node* rhs, bool is_init = false) {
+    if (((lhs->IsConstructor() && rhs->IsConstructor()) || (lhs->IsLam() && rhs->IsLam())) 
+        && lhs->Name() == rhs->Name())
+    {
+        if (lhs->Name() == "ref")
+        {
+            // Add edge between second argument which is a set variable. This argument is covariant so the edge will be from lhs -> rhs
+            if (std::holds_alternative<Node*>(lhs->GetArgAt(1)) && std::holds_alternative<Node*>(rhs->GetArgAt(1)))
+            {
+                AddEdge(std::get<Node*>(lhs->CallArgs().at(1)), std::get<Node*>(rhs->CallArgs().at(1)));
+            }
+        }
+        else if (lhs->Name() == "lam_")
+        {
+            int start_idx = 2;
+            // If ret value is present, all arguments from index 2 are contravariant, else all arguments from index 1 are contravariant
+            if (!lhs->HasRetVal())
+                start_idx = 1;
+            else
+            {
+                if (std::holds_alternative<Node*>(lhs->CallArgs().at(1)) && std::holds_alternative<Node*>(rhs->CallArgs().at(1)))
+                {
+                    Node* lhs_retval = std::get<Node*>(lhs->CallArgs().at(1));
+                    Node* rhs_retval = std::get<Node*>(rhs->CallArgs().at(1));
+                    AddEdge(lhs_retval, rhs_retval);
+                }
+            }
+
+            for (int i = start_idx; i < lhs->CallArgs().size(); i++)
+            {
+                if (std::holds_alternative<Node*>(lhs->GetArgAt(i)) && std::holds_alternative<Node*>(rhs->GetArgAt(i)))
+                {
+                    AddEdge(std::get<Node*>(rhs->CallArgs().at(i)), std::get<Node*>(lhs->CallArgs().at(i)));
+                }
+            }
+        }
+    }
+    else if ((lhs->IsConstructor() || lhs->IsLam()) || rhs->IsProjection())
+    {
+        if (!rhs->HasPredecessor(lhs))
+        {
+            rhs->predecessor_nodes.insert(lhs);
+            if (rhs->IsSetVar() && !is_init)
+            {
+                worklist.Push(rhs);
+            }
+        }
+    }
+    else
+    {
+        if (!lhs->HasSuccessor(rhs))
+        {
+            lhs->successor_nodes.insert(rhs);
+            num_successor_edges += 1;
+            if (lhs->IsSetVar() && !is_init)
+            {
+                worklist.Push(lhs);
+            }
+        }
+    }
+}
+
+/*
+* Gets set variable if already present, otherwise creates a new set variable and returns it
+* Set variables are interned by name: the name views point into the mapped constraint file (or owned_names) so lookups
+* never allocate,
+* and every set variable gets a dense id which is its index into set_vars
+*/
+Node* get_sv(std::string_view sv_name) {
+    auto it = set_var_map.find(sv_name);
+    if (it != set_var_map.end()) {
+        return it->second;
+    }
+    Node *sv = new Node(std::string(sv_name));
+    sv->id = set_vars.size();
+    set_vars.push_back(sv);
+    set_var_map.emplace(sv_name, sv);
+    return sv;
+}
+
+/*
+* Same as get_sv for a name whose storage the caller does not keep alive
+*/
+Node* get_owned_sv(const std::string& sv_name) {
+    auto it = set_var_map.find(sv_name);
+    if (it != set_var_map.end()) {
+        return it->second;
+    }
+    owned_names.push_back(sv_name);
+    return get_sv(owned_names.back());
+}
+
+/*
+* Gets the ref constructor call ref(o[i], o[i]) for the field at offset i of object o, creating it on first use
+*/
+Node* get_field_ref(const std::string& obj, int offset) {
+    auto key = std::make_pair(obj, offset);
+    auto it = field_refs.find(key);
+    if (it != field_refs.end()) {
+        return it->second;
+    }
+    std::string field_name = obj + "[" + std::to_string(offset) + "]";
+
+    std::vector<std::variant<std::string, Node*>> args;
+    args.push_back(field_name);
+    args.push_back(get_owned_sv(field_name));
+    Node* ref = new Node("ref", args);
+    field_refs[key] = ref;
+    return ref;
+}
+
+/*
+* Assign every set variable the position of its SCC in a topological order of the successor graph
+* The graph is collapsed using an iterative version of Tarjan's algorithm. Tarjan emits SCCs in reverse
+* topological order, so the first SCC found gets the largest topo_order.
+* Nodes earlier in the order only push to nodes later in the order (except within a cycle), so processing
+* a wave in this order lets a change flow through the whole graph in a single wave.
+*/
+void ComputeTopoOrder() {
+    // Per node Tarjan state, indexed by Node::id
+    std::vector<int> index(set_vars.size(), -1), lowlink(set_vars.size(), 0);
+    std::vector<bool> on_stack(set_vars.size(), false);
+    std::vector<Node*> stack;
+    int next_index = 0;
+    int num_sccs = 0;
+
+    for (Node* root : set_vars) {
+        if (index[root->id] >= 0)
+            continue;
+
+        // Each frame holds a node and an iterator to the next successor to visit
+        std::vector<std::pair<Node*, std::set<Node*>::iterator>> call_stack;
+        index[root->id] = lowlink[root->id] = next_index++;
+        stack.push_back(root);
+        on_stack[root->id] = true;
+        call_stack.push_back({root, root->successor_nodes.begin()});
+
+        while (!call_stack.empty()) {
+            Node* node = call_stack.back().first;
+            auto& it = call_stack.back().second;
+
+            if (it != node->successor_nodes.end()) {
+                Node* succ = *it;
+                ++it;
+                if (!succ->IsSetVar())
+                    continue;
+                if (index[succ->id] < 0) {
+                    index[succ->id] = lowlink[succ->id] = next_index++;
+                    stack.push_back(succ);
+                    on_stack[succ->id] = true;
+                    call_stack.push_back({succ, succ->successor_nodes.begin()});
+                }
+                else if (on_stack[succ->id]) {
+                    lowlink[node->id] = std::min(lowlink[node->id], index[succ->id]);
+                }
+                continue;
+            }
+
+            // All successors visited - pop the SCC if node is its root
+            if (lowlink[node->id] == index[node->id]) {
+                Node* member = nullptr;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member->id] = false;
+                    member->topo_order = num_sccs;
+                } while (member != node);
+                num_sccs += 1;
+            }
+            call_stack.pop_back();
+            if (!call_stack.empty()) {
+                Node* parent = call_stack.back().first;
+                lowlink[parent->id] = std::min(lowlink[parent->id], lowlink[node->id]);
+            }
+        }
+    }
+
+    // Reverse the SCC numbering so that sources come first
+    for (Node* node : set_vars) {
+        node->topo_order = num_sccs - 1 - node->topo_order;
+    }
+}
+
+/*
+* Solver algorithm
+* 1. Worklist is initialized with all set variables that have a predecessor edge 
+* 2. While worklist is not empty, 
+    2.a. Pop a set variable X from the worklist
+    2.b. Add edges from X's predecessor edges to it's successor edges
+        2.b.1 If destination node's predecessor edges change, put dest on worklist (if it's a set variable)
+    2.c For each projection node P of X
+        2.c.1 Let Y = value of P
+        2.c.2 For each predecessor Pi of P and successor Si of P and each yi in Y
+            2.c.2.1 Add edge Pi -> yi
+            2.c.2.2 Add edge yi -> Si
+            2.c.2.3 If Pi's successor edges change, put Pi on worklist (if it's a set variable)
+            2.c.2.4 If Si's predecessor edges change, put Si on worklist (if it's a set variable)
+            2.c.2.5 If yi has new edges, add yi to the worklist (if it's a set variable)
+* The worklist never holds duplicates and is processed in waves ordered by the configured policy (see worklist.hpp)
+*/
+void Solve() {
+
+    // Step 1 - Initialoze worklist with all set variables that have a predecessor edge
+    for (Node* node : set_vars) {
+        if (!node->predecessor_nodes.empty()) {
+            worklist.Push(node);
+        }
+    }
+
+    // Size of the successor graph the current topological order was computed for
+    long topo_edges = -1;
+    size_t topo_nodes = 0;
+
+    while(!worklist.Empty()) {
+        // Edges added by projections change the collapsed graph, so refresh the order before a wave if any were added
+        if (worklist.Policy() == WorklistPolicy::TOPO && worklist.AtWaveBoundary()
+            && (topo_edges != num_successor_edges || topo_nodes != set_vars.size())) {
+            ComputeTopoOrder();
+            topo_edges = num_successor_edges;
+            topo_nodes = set_vars.size();
+        }
+        Node* sv_node = worklist.Pop();
+
+        // Step 2.b
+        for (auto pred : sv_node->predecessor_nodes) {
+            for (auto succ : sv_node->successor_nodes) {
+                AddEdge(pred, succ);
+            }
+        }
+
+        // Step 2.c
+        for (auto proj_sv_ref : sv_node->proj_sv_refs) {
+            std::set<Node*> Y;
+            // Get the set variable for the projection
+            Node *sv_for_proj = proj_sv_ref->ProjSV();
+
+            // Step 2.d - offset projection: the field at the projected offset of every object the set variable points to
+            // flows into the successors of the projection
+            if (proj_sv_ref->Name() == "gfp") {
+                std::vector<Node*> fields;
+                for (auto pred : sv_for_proj->predecessor_nodes) {
+                    if (pred->IsConstructor() && pred->Name() == "ref" && std::holds_alternative<std::string>(pred->GetArgAt(0))) {
+                        fields.push_back(get_field_ref(std::get<std::string>(pred->GetArgAt(0)), proj_sv_ref->ProjIdx()));
+                    }
+                }
+                for (auto field : fields) {
+                    for (auto succ : proj_sv_ref->successor_nodes) {
+                        int num_of_edges_succ = succ->predecessor_nodes.size() + succ->successor_nodes.size();
+                        AddEdge(field, succ, true);
+                        if (succ->IsSetVar() && succ->predecessor_nodes.size() + succ->successor_nodes.size() > num_of_edges_succ) {
+                            worklist.Push(succ);
+                        }
+                    }
+                }
+                continue;
+            }
+
+            // For every predecessor of the set variable that is a constructor and the name matches the projection name,
+            // compute the value of the projection
+            // We don't consider lams here because projections are only on ref constructor calls
+            for (auto pred : sv_for_proj->predecessor_nodes) {
+                if (pred->IsConstructor() && pred->Name() == proj_sv_ref->Name()) {
+
+                    // Projections are always only on ref constructor calls with position 1 => this will always be a set variable
+                    std::variant<std::string, Node*> arg = pred->GetArgAt(proj_sv_ref->ProjIdx());
+                    if (std::holds_alternative<Node*>(arg)) {
+                        Node* arg_node = std::get<Node*>(arg);
+                        Y.insert(arg_node);
+                    }
+                }
+            }
+
+            for (auto yi : Y)
+            {
+                int num_of_edges_yi = yi->predecessor_nodes.size() + yi->successor_nodes.size();
+                for (auto pred : proj_sv_ref->predecessor_nodes) {
+                    int num_of_edges_pred = pred->predecessor_nodes.size() + pred->successor_nodes.size();
+                    AddEdge(pred, yi, true);
+                    if (pred->IsSetVar() && pred->predecessor_nodes.size() + pred->successor_nodes.size() > num_of_edges_pred) {
+                        worklist.Push(pred);
+                    }
+                }
+                for (auto succ : proj_sv_ref->successor_nodes) {
+                    int num_of_edges_succ = succ->predecessor_nodes.size() + succ->successor_nodes.size();
+                    // Pass is_init as true since we don't want this function to control adding to the worklist
+                    AddEdge(yi, succ, true);
+                    if (succ->IsSetVar() && succ->predecessor_nodes.size() + succ->successor_nodes.size() > num_of_edges_succ) {
+                        worklist.Push(succ);
+                    }
+                }
+                // Add yi to worklist if the edges have changed
+                if (yi->predecessor_nodes.size() + yi->successor_nodes.size() > num_of_edges_yi) {
+                    worklist.Push(yi);
+                }
+            }
+        }
+    }
+}
+
+/*
+* Solution is the predecessor edges of all set variable which are constructors
+* for a ref constructor, it is the first argument and for lam constructor, it is the first argument as well
+*/
+std::map<std::string, std::set<std::string>> GetSolution() {
+    std::map<std::string, std::set<std::string>> solution;
+    for (Node* node : set_vars) {
+        const std::string name = node->Name();
+        for (auto pred : node->predecessor_nodes) {
+            if (pred->IsConstructor() || pred->IsLam()) {
+                if (std::holds_alternative<std::string>(pred->GetArgAt(0))) {
+                    std::string arg_name = std::get<std::string>(pred->GetArgAt(0));
+                    solution[name].insert(arg_name);
+                }
+            }
+        }
+    }
+    return solution;
+}
+
+/*
+* Print the solution in the points-to file format read by the taint analysis and the slicer
+*/
+void PrintSolution(const std::map<std::string, std::set<std::string>>& solution, std::ostream& out) {
+    for (auto const& [name, preds] : solution) {
+        out << name << " -> {";
+        int i = 0;
+        for (auto pred : preds) {
+            if (i != preds.size() - 1) {
+                out << pred << ", ";
+            } else {
+                out << pred;
+            }
+            i += 1;
+        }
+        out << "}" << std::endl;
+    }
+    out << std::endl;
+}
+
+} // namespace pta
@@ -0,0 +1,71 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "./points_to_pipeline.hpp"
+
+using namespace pta;
+
+/*
+* Constraint generation and solving in one process
+* Prints the same solution as running assn3-constraint-generator followed by assn3_constraint_solver
+*/
+int main(int argc, char* argv[]) {
+    const char* usage = "Usage: points-to <lir json> [fifo|lrf|topo] [--field-sensitive] [--field-cap <n>] "
+                        "[--threads <n>] [--dump-constraints <file>] [--stats]";
+    if (argc < 2) {
+        std::cerr << usage << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool print_stats = false;
+    const char* dump_path = nullptr;
+    for (int i = 2; i < argc; i++) {
+        WorklistPolicy policy;
+        if (std::strcmp(argv[i], "--stats") == 0) {
+            print_stats = true;
+        }
+        else if (std::strcmp(argv[i], "--field-sensitive") == 0) {
+            field_sensitive = true;
+        }
+        else if (std::strcmp(argv[i], "--field-cap") == 0 && i + 1 < argc) {
+            field_sensitive = true;
+            field_cap = std::stoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = std::stoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--dump-constraints") == 0 && i + 1 < argc) {
+            dump_path = argv[++i];
+        }
+        else if (Worklist::ParsePolicy(argv[i], policy)) {
+            worklist.SetPolicy(policy);
+        }
+        else {
+            std::cerr << usage << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Program p = Program(json::parse(std::ifstream(argv[1])));
+
+    std::ofstream dump;
+    if (dump_path) {
+        dump.open(dump_path);
+        if (!dump) {
+            std::cerr << "Could not open " << dump_path << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::map<std::string, std::set<std::string>> solution = ComputePointsTo(p, dump_path ? &dump : nullptr);
+
+    if (print_stats) {
+        std::cerr << "Worklist policy: " << Worklist::PolicyName(worklist.Policy())
+                  << ", nodes processed: " << worklist.NumProcessed()
+                  << ", waves: " << worklist.NumWaves() << std::endl;
+    }
+
+    PrintSolution(solution, std::cout);
+    return 0;
+}
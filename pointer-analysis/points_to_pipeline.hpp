@@ -0,0 +1,145 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "../constraint-generator/constraint_generator.hpp"
+#include "./constraint_solver.hpp"
+
+/*
+* In-process points-to pipeline
+* The statements built by the constraint generator are turned straight into solver nodes, so there is no
+* render -> sort -> tokenize round trip through the constraint text. ref and lam constructor calls and projections
+* are pure, so they are hash-consed: the same expression becomes the same node however many statements mention it,
+* which is what the generator's string-set dedup used to take care of.
+*/
+namespace pta {
+
+std::unordered_map<std::string, Node*> ref_nodes;
+std::map<std::tuple<std::string, int, Node*>, Node*> proj_nodes;
+// lam_ nodes keyed by (constructor name with its type, function name, set variable arguments)
+std::map<std::tuple<std::string, std::string, std::vector<Node*>>, Node*> lam_nodes;
+
+Node* BuildSetVar(const SetVariable& v) {
+    return get_owned_sv(build_set_var_str(v));
+}
+
+/*
+* Build the lam_ node for a constructor named lam_[(<param types>)-><ret type>]
+*/
+Node* BuildLam(const Constructor& c) {
+    // The first argument is the function name, the rest are set variables
+    std::string func_name;
+    std::vector<Node*> arg_svs;
+    for (int i = 0; i < c.args.size(); i++) {
+        const SetVariable& arg = std::get<SetVariable>(c.args[i]);
+        if (i == 0)
+            func_name = build_set_var_str(arg);
+        else
+            arg_svs.push_back(BuildSetVar(arg));
+    }
+    auto key = std::make_tuple(c.name, func_name, arg_svs);
+    auto it = lam_nodes.find(key);
+    if (it != lam_nodes.end()) {
+        return it->second;
+    }
+
+    std::string type_str = c.name.substr(c.name.find('[') + 1);
+    type_str = type_str.substr(0, type_str.rfind(']'));
+
+    size_t arrow = type_str.rfind("->");
+    std::string params = type_str.substr(1, arrow - 2);
+    std::string ret_type = type_str.substr(arrow + 2);
+
+    std::vector<std::string> param_types;
+    size_t start = 0;
+    while (start < params.size()) {
+        size_t comma = params.find(',', start);
+        if (comma == std::string::npos)
+            comma = params.size();
+        param_types.push_back(params.substr(start, comma - start));
+        start = comma + 1;
+    }
+
+    std::vector<std::variant<std::string, Node*>> args;
+    if (!c.args.empty())
+        args.push_back(func_name);
+    for (Node* sv : arg_svs)
+        args.push_back(sv);
+    Node* lam = new Node("lam_", args, ret_type, param_types);
+    lam_nodes[key] = lam;
+    return lam;
+}
+
+Node* BuildNode(const Expression& e) {
+    if (std::holds_alternative<Projection>(e)) {
+        const Projection& proj = std::get<Projection>(e);
+        Node* sv = BuildSetVar(proj.v);
+        auto key = std::make_tuple(proj.c.name, proj.arg, sv);
+        auto it = proj_nodes.find(key);
+        if (it != proj_nodes.end()) {
+            return it->second;
+        }
+        Node* proj_node = new Node(proj.c.name, sv, proj.arg);
+        // Add projection reference to set variable whose projection it is
+        sv->proj_sv_refs.insert(proj_node);
+        proj_nodes[key] = proj_node;
+        return proj_node;
+    }
+
+    const Term& term = std::get<Term>(e);
+    if (std::holds_alternative<SetVariable>(term)) {
+        return BuildSetVar(std::get<SetVariable>(term));
+    }
+
+    const Constructor& c = std::get<Constructor>(term);
+    if (c.name != "ref") {
+        return BuildLam(c);
+    }
+    // ref has two arguments: the constant naming the program variable and its set variable
+    std::string const_name = build_set_var_str(std::get<SetVariable>(c.args[0]));
+    auto it = ref_nodes.find(const_name);
+    if (it != ref_nodes.end()) {
+        return it->second;
+    }
+    std::vector<std::variant<std::string, Node*>> args;
+    args.push_back(const_name);
+    args.push_back(BuildSetVar(std::get<SetVariable>(c.args[1])));
+    Node* ref = new Node("ref", args);
+    ref_nodes[const_name] = ref;
+    return ref;
+}
+
+void AddStatement(const Statement& s) {
+    AddEdge(BuildNode(s.e1), BuildNode(s.e2), true);
+}
+
+/*
+* Generate the constraints for the program, solve them and return the points-to solution
+* If dump is given, the constraints are also written to it in the generator's text format.
+*/
+std::map<std::string, std::set<std::string>> ComputePointsTo(Program& p, std::ostream* dump = nullptr) {
+    std::vector<Statement> constraints = GenerateConstraints(p);
+
+    if (dump) {
+        std::set<std::string> str_constraints;
+        for (const auto& constraint : constraints) {
+            str_constraints.insert(build_constraint(constraint));
+        }
+        for (const auto& constraint_str : str_constraints) {
+            *dump << constraint_str;
+        }
+    }
+
+    for (const auto& constraint : constraints) {
+        AddStatement(constraint);
+    }
+    Solve();
+    return GetSolution();
+}
+
+} // namespace pta
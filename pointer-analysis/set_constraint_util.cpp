@@ -1,14 +1,22 @@
+#ifndef SET_CONSTRAINT_UTIL_CPP
+#define SET_CONSTRAINT_UTIL_CPP
+
 #include<iostream>
 #include<string>
 #include<vector>
 #include<set>
 #include<variant>
+
+namespace pta {
+
 /*
 * Defining set constraint language
 * x = set variable 
 * c = constructor
 * t = term = x | c(t1, t2, ..., tn) 
 * e = expression = t | proj(c, x, i)
+* proj(gfp, x, i) is the offset projection used by the field-sensitive mode: it denotes the field at offset i
+* of every object x points to, where the field of object o is the abstract location o[i]
 * s = statement = e1 <= e2 | s1 ^ s2
 */
 
@@ -28,6 +36,18 @@ class Node {
     public:
     std::set<Node*> proj_sv_refs, predecessor_nodes, successor_nodes;
 
+    /*
+    * Solver bookkeeping for set variables
+    * id: creation order of the set variable, used to break ties between equal worklist priorities
+    * in_worklist: true while the node is waiting on the worklist so that it is never queued twice
+    * last_fired: value of the solver clock when the node was last popped (used by the LRF policy)
+    * topo_order: position of the node's SCC in a topological order of the successor graph (used by the TOPO policy)
+    */
+    int id = -1;
+    bool in_worklist = false;
+    long last_fired = 0;
+    int topo_order = 0;
+
     Node(const std::string name) : name(name) {
         type = NodeType::SET_VAR;
     }
@@ -36,7 +56,7 @@ class Node {
         type = NodeType::CONSTRUCTOR;
     }
 
-    Node(const std::string name, const std::string proj_sv, int proj_idx) : name(name), proj_sv_(proj_sv), proj_idx_(proj_idx) {
+    Node(const std::string name, Node* proj_sv, int proj_idx) : name(name), proj_sv_(proj_sv), proj_idx_(proj_idx) {
         type = NodeType::PROJECTION;
     }
 
@@ -53,7 +73,7 @@ class Node {
     const std::string Name() const { return name; }
     std::vector<std::variant<std::string, Node*>> CallArgs() { return args; }
     std::variant<std::string, Node*> GetArgAt(int pos) { return args.at(pos); }
-    const std::string ProjSV() const { return proj_sv_; }
+    Node* ProjSV() const { return proj_sv_; }
     const int ProjIdx() const { return proj_idx_; }
 
     const bool IsSetVar() const { return type == NodeType::SET_VAR; }
@@ -74,9 +94,13 @@ class Node {
     NodeType type;
     std::string name;
     std::vector<std::variant<std::string, Node*>> args;
-    std::string proj_sv_;
+    Node* proj_sv_ = nullptr;
     int proj_idx_;
     std::string ret_type;
     std::vector<std::string> param_types;
     bool does_ret_val;
-};
\ No newline at end of file
+};
+
+} // namespace pta
+
+#endif // SET_CONSTRAINT_UTIL_CPP
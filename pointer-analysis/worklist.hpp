@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+#include "./set_constraint_util.cpp"
+
+namespace pta {
+
+/*
+* Order in which dirty set variables are processed by the solver
+* FIFO: nodes are processed in the order they became dirty
+* LRF: least recently fired first i.e nodes that have waited longest since they were last processed go first
+* TOPO: nodes are processed in topological order of the collapsed (SCC condensed) successor graph
+*/
+enum WorklistPolicy {
+    FIFO,
+    LRF,
+    TOPO
+};
+
+/*
+* Worklist of set variables that is processed in waves
+* 1. A node is only ever queued once - Push is a no-op while the node's in_worklist flag is set
+* 2. Nodes pushed while a wave is being processed are deferred to the next wave
+* 3. At the start of every wave the pending nodes are ordered according to the policy
+* This guarantees that every dirty node is processed at most once per wave
+*/
+class Worklist {
+    public:
+
+    Worklist(WorklistPolicy policy = WorklistPolicy::FIFO) : policy_(policy) {}
+
+    void SetPolicy(WorklistPolicy policy) { policy_ = policy; }
+    WorklistPolicy Policy() const { return policy_; }
+
+    void Push(Node* node) {
+        if (node->in_worklist)
+            return;
+        node->in_worklist = true;
+        pending_.push_back(node);
+    }
+
+    Node* Pop() {
+        if (current_.empty())
+            StartWave();
+        Node* node = current_.front();
+        current_.pop_front();
+        node->in_worklist = false;
+        node->last_fired = ++clock_;
+        return node;
+    }
+
+    bool Empty() const { return current_.empty() && pending_.empty(); }
+
+    /*
+    * True when the current wave has been fully processed and the next Pop starts a new wave
+    * The solver uses this to refresh the topological order before the wave is sorted
+    */
+    bool AtWaveBoundary() const { return current_.empty(); }
+
+    long NumProcessed() const { return clock_; }
+    long NumWaves() const { return waves_; }
+
+    static bool ParsePolicy(const std::string& name, WorklistPolicy& policy) {
+        if (name == "fifo")
+            policy = WorklistPolicy::FIFO;
+        else if (name == "lrf")
+            policy = WorklistPolicy::LRF;
+        else if (name == "topo")
+            policy = WorklistPolicy::TOPO;
+        else
+            return false;
+        return true;
+    }
+
+    static std::string PolicyName(WorklistPolicy policy) {
+        switch (policy) {
+            case WorklistPolicy::LRF:
+                return "lrf";
+            case WorklistPolicy::TOPO:
+                return "topo";
+            default:
+                return "fifo";
+        }
+    }
+
+    private:
+
+    void StartWave() {
+        waves_ += 1;
+        if (policy_ == WorklistPolicy::LRF) {
+            std::stable_sort(pending_.begin(), pending_.end(), [](Node* a, Node* b) {
+                if (a->last_fired != b->last_fired)
+                    return a->last_fired < b->last_fired;
+                return a->id < b->id;
+            });
+        }
+        else if (policy_ == WorklistPolicy::TOPO) {
+            std::stable_sort(pending_.begin(), pending_.end(), [](Node* a, Node* b) {
+                if (a->topo_order != b->topo_order)
+                    return a->topo_order < b->topo_order;
+                return a->id < b->id;
+            });
+        }
+        current_.assign(pending_.begin(), pending_.end());
+        pending_.clear();
+    }
+
+    WorklistPolicy policy_;
+    std::deque<Node*> current_;
+    std::vector<Node*> pending_;
+    long clock_ = 0;
+    long waves_ = 0;
+};
+
+} // namespace pta
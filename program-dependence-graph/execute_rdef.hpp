@@ -4,142 +4,48 @@
 #include<set>
 #include<iostream>
 #include "../headers/datatypes.h"
+#include "../headers/gen_kill.hpp"
+#include "../headers/points_to_index.hpp"
+#include "../headers/type_graph.hpp"
 #include <deque>
 #include <unordered_set>
 #include <unordered_map>
-#include "rtype.hpp"
 #include <queue>
 #include "mod_ref_utils.hpp"
 
 /*
- * Join is a union of the two abstract stores where each abstract store is a map of variable name to a set of pp where they are defined.
+* Name of a points-to location as a variable of func: locals and parameters of func drop their func. prefix
 */
-bool joinAbsStore(std::map<std::string, std::set<std::string>>&curr_abs_store, std::map<std::string, std::set<std::string>>parent_bb_abs_store) {
-    
-    bool changed = false;
-    std::map<std::string, std::set<std::string>> result_set;
-    
-    // For elements in curr_abs_store, do a set union with the parent_bb_abs_store
-    // This also handles the case when the key is not present in parent_bb_abs_store but present in curr_abs_store
-    for(auto it = curr_abs_store.begin(); it != curr_abs_store.end(); it++) {
-        std::set<std::string> result_set;
-        std::set_union(it->second.begin(), it->second.end(), parent_bb_abs_store[it->first].begin(), parent_bb_abs_store[it->first].end(), std::inserter(result_set, result_set.begin()));
-        // We do not want to unset changed to false if alerady set to true
-        if (!changed)
-            changed = (result_set.size() != it->second.size());
-        it->second = result_set;
-    }
-
-    // For elements in parent_bb_abs_store, if they are not in curr_abs_store, add them to curr_abs_store
-    for(auto it = parent_bb_abs_store.begin(); it != parent_bb_abs_store.end(); it++) {
-        if(curr_abs_store.count(it->first) == 0) {
-            curr_abs_store[it->first] = it->second;
-            changed = true;
-        }
-    }
-    return changed;
-}
-
-bool joinSets(std::set<std::string> &s1, std::set<std::string> &s2) {
-    bool changed = false;
-    std::set<std::string> result_set;
-    
-    std::set_union(s1.begin(), s1.end(), s2.begin(), s2.end(), std::inserter(result_set, result_set.begin()));
-    
-    changed = (result_set.size() != s1.size());
-    s1 = result_set;
-    return changed;
-}
-
-bool isGlobalVar(Variable *var, Program *program, std::string func_name) {
-    
-    if (program->funcs[func_name]->locals.count(var->name) > 0)
-        return false;
-
-    for (auto gl : program->globals) {
-        if (gl->globalVar->name == var->name)
-            return true;
-    }
-    return false;
+std::string LocalName(const std::string &location, Function *func) {
+    std::string prefix = func->name + ".";
+    if (location.compare(0, prefix.size(), prefix) == 0)
+        return location.substr(prefix.size());
+    return location;
 }
 
-std::set<std::string> GetReachable(std::vector<Operand*> args, std::unordered_map<std::string, std::set<std::string>> pointsTo, Program *program) {
-    std::set<std::string> reachable;
-    std::queue<std::string> q;
-    std::set<std::string> visited;
-
-
+/*
+* Globals and the abstract locations reachable from the arguments or the globals
+* The closures come precomputed from the PointsToIndex, so this is a union of closures.
+*/
+std::set<std::string> GetReachable(std::vector<Operand*> args, const PointsToIndex& pointsTo, Program *program) {
+    std::vector<int> var_ids;
     for(const auto& op: args) {
         if(!op->IsConstInt()) {
-            std::string var = op->var->name;
-            // TODO - Parameterize func name. For now, since it's always test, hardcoding it
-            std::string pointsToVarName = isGlobalVar(op->var, program, "test") ? var : "test." + var;
-
-            if(pointsTo.count(pointsToVarName)) {
-                for(auto v: pointsTo[pointsToVarName]) {
-                    
-                    if (visited.count(v) == 0) {
-                        visited.insert(v);
-                        q.push(v);
-                    }
-                    reachable.insert(v);
-
-                }
-
-                while(!q.empty()) {
-
-                    std::string tmp = q.front();
-                    q.pop();
-                    
-                    if(pointsTo.count(tmp)) {
-                        for(auto v: pointsTo[tmp]) {
-                            
-                            if (visited.count(v) == 0) {
-                                visited.insert(v);
-                                q.push(v);
-                            }
-                            reachable.insert(v);
-                        }
-                    }
-                }
-            }
+            // Points-to key resolved at load time: func.name for locals, the bare name for globals
+            var_ids.push_back(pointsTo.GetId(op->var->key));
         }
     }
     // Globals + All objects reachable from globals
+    for (auto gl : program->globals) {
+        var_ids.push_back(pointsTo.GetId(gl->globalVar->name));
+    }
 
-    std::set<std::string> visited_globals;
-
+    std::set<std::string> reachable;
+    for (int id : pointsTo.Reachable(var_ids)) {
+        reachable.insert(reachable.end(), pointsTo.Name(id));
+    }
     for (auto gl : program->globals) {
         reachable.insert(gl->globalVar->name);
-
-        if (!pointsTo.count(gl->globalVar->name))
-            continue;
-
-        for (auto v : pointsTo[gl->globalVar->name]) {
-            
-            if (visited_globals.count(v) == 0) {
-                visited_globals.insert(v);
-                q.push(v);
-            }
-            reachable.insert(v);
-        }
-
-        while (!q.empty()) {
-
-            std::string tmp = q.front();
-            q.pop();
-
-            if (pointsTo.count(tmp)) {
-                for (auto v : pointsTo[tmp]) {
-                    
-                    if (visited_globals.count(v) == 0) {
-                        visited_globals.insert(v);
-                        q.push(v);
-                    }
-                    reachable.insert(v);
-                }
-            }
-        }
     }
     return reachable;
 }
@@ -170,27 +76,47 @@ std::set<std::string> GetDefs(std::set<std::string> callees, std::set<std::strin
     return defs;
 }
 
-void execute(
+/*
+ * DEF/USE sets of every program point of bb and its successors
+ * Loads, stores and calls use the points-to solution and the mod/ref summaries of the callees, so the points-to
+ * lookups and the reachability closures of calls are done once here rather than on every worklist visit.
+ */
+BlockDefUse GetBlockDefUse(
     Program *program,
-    std::unordered_map<std::string, std::set<std::string>> &pointsTo,
+    const TypeGraph &types,
+    const PointsToIndex& pointsTo,
     std::map<std::string, ModRefInfo> &modRefInfo,
+    Function *func,
     BasicBlock *bb,
-    std::map<std::string, std::map<std::string, std::set<std::string>>> &bb2store,
-    std::deque<std::string> &worklist,
     std::unordered_set<Variable*> &addr_taken,
-    std::set<std::string> &bbs_to_output,
-    std::map<std::string, std::set<std::string>> &soln,
-    bool execute_final = false
+    DefTable &defs
 )
 {
-    std::map<std::string, std::set<std::string>> sigma_prime = bb2store[bb->label];
+    BlockDefUse block;
+    block.label = bb->label;
+
+    auto add = [&](const std::string &pp, const std::set<std::string> &USE, const std::set<std::string> &WDEF, Variable *SDEF) {
+        DefUse du;
+        du.pp = pp;
+        for (const std::string &v : USE)
+            du.uses.push_back(defs.Var(v));
+        for (const std::string &v : WDEF) {
+            int var = defs.Var(v);
+            du.weak_defs.push_back({var, defs.Def(pp, var)});
+        }
+        if (SDEF) {
+            int var = defs.Var(SDEF->name);
+            du.strong_defs.push_back({var, defs.Def(pp, var)});
+        }
+        block.pps.push_back(du);
+    };
+    auto names = [](const std::set<Variable*> &vars) {
+        std::set<std::string> result;
+        for (Variable *v : vars)
+            result.insert(v->name);
+        return result;
+    };
 
-    /*
-     * We define DEF for definitions of the variable and USE for the uses of the variable.
-     * DEF = set of variables
-     * USE = set of variables
-    */
-    
     int index = 0; // To help build program point name
 
     /*
@@ -199,17 +125,11 @@ void execute(
     for (const Instruction *inst : bb->instructions) {
 
         std::string pp = bb->label + "." + std::to_string(index);
+        std::set<std::string> USE;
 
         // arith, cmp, alloc, copy, gep, gfp work the same way
         if ((*inst).instrType == InstructionType::ArithInstrType) {
-
-            /*
-             * Cast it.
-             */
-             ArithInstruction *arith_inst = (ArithInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
-
+            ArithInstruction *arith_inst = (ArithInstruction *) inst;
             /*
              * x = $arith add y z
              * DEF = {x}
@@ -217,29 +137,15 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(arith_inst->lhs);
             if (!arith_inst->op1->IsConstInt())
-                USE.insert(arith_inst->op1->var);
+                USE.insert(arith_inst->op1->var->name);
             if (!arith_inst->op2->IsConstInt())
-                USE.insert(arith_inst->op2->var);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[arith_inst->lhs->name] = {pp};
+                USE.insert(arith_inst->op2->var->name);
+            add(pp, USE, {}, arith_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::CmpInstrType)
         {
-            /*
-             * Cast it.
-             */
-             CmpInstruction *cmp_inst = (CmpInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            CmpInstruction *cmp_inst = (CmpInstruction *) inst;
             /*
              * x = $cmp gt y z
              * DEF = {x}
@@ -247,29 +153,15 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(cmp_inst->lhs);
             if (!cmp_inst->op1->IsConstInt())
-                USE.insert(cmp_inst->op1->var);
+                USE.insert(cmp_inst->op1->var->name);
             if (!cmp_inst->op2->IsConstInt())
-                USE.insert(cmp_inst->op2->var);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[cmp_inst->lhs->name] = {pp};
+                USE.insert(cmp_inst->op2->var->name);
+            add(pp, USE, {}, cmp_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::CopyInstrType)
         {
-            /*
-             * Cast it.
-             */
-             CopyInstruction *copy_inst = (CopyInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            CopyInstruction *copy_inst = (CopyInstruction *) inst;
             /*
              * x = $copy y
              * DEF = {x}
@@ -277,27 +169,13 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(copy_inst->lhs);
             if (!copy_inst->op->IsConstInt())
-                USE.insert(copy_inst->op->var);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[copy_inst->lhs->name] = {pp};
+                USE.insert(copy_inst->op->var->name);
+            add(pp, USE, {}, copy_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::AllocInstrType)
         {
-            /*
-             * Cast it.
-             */
-             AllocInstruction *alloc_inst = (AllocInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            AllocInstruction *alloc_inst = (AllocInstruction *) inst;
             /*
              * x = $alloc y [id]
              * DEF = {x}
@@ -305,28 +183,13 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(alloc_inst->lhs);
             if (!alloc_inst->num->IsConstInt())
-                USE.insert(alloc_inst->num->var);
-
-            if (execute_final) {
-
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[alloc_inst->lhs->name] = {pp};
+                USE.insert(alloc_inst->num->var->name);
+            add(pp, USE, {}, alloc_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::GepInstrType)
         {
-            /*
-             * Cast it.
-             */
-             GepInstruction *gep_inst = (GepInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            GepInstruction *gep_inst = (GepInstruction *) inst;
             /*
              * x = $gep id op
              * DEF = {x}
@@ -334,26 +197,15 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(gep_inst->lhs);
             if (!gep_inst->idx->IsConstInt())
-                USE.insert(gep_inst->idx->var);
+                USE.insert(gep_inst->idx->var->name);
             // TODO - Confirm this with Ben
-            USE.insert(gep_inst->src);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[gep_inst->lhs->name] = {pp};
+            USE.insert(gep_inst->src->name);
+            add(pp, USE, {}, gep_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::GfpInstrType)
         {
-             GfpInstruction *gfp_inst = (GfpInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            GfpInstruction *gfp_inst = (GfpInstruction *) inst;
             /*
              * x = $gfp id id
              * DEF = {x}
@@ -361,27 +213,13 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(gfp_inst->lhs);
-            USE.insert(gfp_inst->src);
+            USE.insert(gfp_inst->src->name);
             //USE.insert(gfp_inst->field);
-            
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[gfp_inst->lhs->name] = {pp};
+            add(pp, USE, {}, gfp_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::AddrofInstrType)
         {
-            /*
-             * Cast it.
-             */
-             AddrofInstruction *addrof_inst = (AddrofInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            AddrofInstruction *addrof_inst = (AddrofInstruction *) inst;
             /*
              * x = $addrof y
              * DEF = {x}
@@ -389,159 +227,86 @@ void execute(
              * No update to soln required
              * sigma_prime[x] = { pp }
             */
-
-            DEF.insert(addrof_inst->lhs);
-            USE = {};
-
-            sigma_prime[addrof_inst->lhs->name] = { pp };
+            add(pp, USE, {}, addrof_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::LoadInstrType)
         {
-            /*
-             * Cast it.
-             */
             LoadInstruction *load_inst = (LoadInstruction *) inst;
-            std::set<std::string> DEF;
-            std::set<std::string> USE;
 
             /*
              * DEF = {x}
-             * USE = {y} U pointsTo[y]
+             * USE = {y} U pointsTo.PointsTo(y)
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(load_inst->lhs->name);
             USE.insert(load_inst->src->name);
 
-            std::string pointsToVarName = isGlobalVar(load_inst->src, program, "test") ? load_inst->src->name : "test." + load_inst->src->name;
-            if (pointsTo.count(pointsToVarName)) {
-                for (auto pts_to : pointsTo[pointsToVarName]) {
-                    // remove test. from pts_to
-                    if (pts_to.find("test.") != std::string::npos)
-                        pts_to = pts_to.substr(pts_to.find("test.") + 5);
-                    USE.insert(pts_to);
-                }
-            }
-
-            if (execute_final) {
-                for (std::string v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v]);
-                }
+            if (pointsTo.Contains(load_inst->src->key)) {
+                for (const auto& pts_to : pointsTo.PointsTo(load_inst->src->key))
+                    USE.insert(LocalName(pts_to, func));
             }
-
-            sigma_prime[load_inst->lhs->name] = {pp};
+            add(pp, USE, {}, load_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::StoreInstrType)
         {
             StoreInstruction *store_inst = (StoreInstruction *) inst;
             std::set<std::string> DEF;
-            std::set<std::string> USE;
 
             /*
              * $store x op
-             * DEF = pointsTo[x]
+             * DEF = pointsTo.PointsTo(x)
              * USE = {x} U { op | op is a variable }
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * for all v in DEF: sigma_prime[v] = sigma_prime[v] U { pp }
             */
-           // TODO - Parameterize func name. For now, since it's always test, hardcoding it
-           std::string pointsToVarName = isGlobalVar(store_inst->dst, program, "test") ? store_inst->dst->name : "test." + store_inst->dst->name;
-            if (pointsTo.count(pointsToVarName)) {
-                for (auto pts_to : pointsTo[pointsToVarName]) {
-                    // Remove test. from pts_to
-                    if (pts_to.find("test.") != std::string::npos)
-                        pts_to = pts_to.substr(pts_to.find("test.") + 5);
-                    DEF.insert(pts_to);
-                }
+            if (pointsTo.Contains(store_inst->dst->key)) {
+                for (const auto& pts_to : pointsTo.PointsTo(store_inst->dst->key))
+                    DEF.insert(LocalName(pts_to, func));
             }
 
             USE.insert(store_inst->dst->name);
             if (!store_inst->op->IsConstInt())
                 USE.insert(store_inst->op->var->name);
-
-            if (execute_final) {
-                for (std::string v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v]);
-                }
-            }
-
-            for (std::string v : DEF) {
-                sigma_prime[v].insert(pp);
-            }
+            add(pp, USE, DEF, nullptr);
         }
         else if ((*inst).instrType == InstructionType::CallExtInstrType)
         {
             CallExtInstruction *callext_inst = (CallExtInstruction *) inst;
-            std::set<Variable*> USE;
             /*
              * SDEF = {x} - Strong defs - definitely updating the variable
              * WDEF = { globals } U { v in addr_taken | type(v) in reachable_types(globals) } U { v in addr_taken | type(v) in reachable_types(args) } - Weak defs - may be updating the variable
-             * USE = { fp } U { arg | arg is a variable } U WDEF // add fp only in case of call_idr
+             * USE = { arg | arg is a variable } U WDEF
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * for all v in WDEF: sigma_prime[v] = sigma_prime[v] U { pp }
              * sigma_prime[x] = { pp }
             */
-            std::set<Variable*> SDEF;
             std::set<Variable*> WDEF;
 
-            if (callext_inst->lhs)
-                SDEF.insert(callext_inst->lhs);
-            
             // Add all globals to WDEF
             for (auto it = program->globals.begin(); it != program->globals.end(); it++) {
                 WDEF.insert((*it)->globalVar);
             }
 
-            // Get reachable types for all globals
-            std::unordered_set<ReachableType*> global_reachable_types;
-            for (auto gl : program->globals) {
-                ReachableType *var_type = new ReachableType(gl->globalVar->type);
-                ReachableType::GetReachableType(program, var_type, global_reachable_types);
-            }
-
-            // Get reachable types for all args
-            std::unordered_set<ReachableType*> args_reachable_types;
+            // Reachable types of the globals and of the args
+            BitVector reachable_types = types.GlobalsReachable();
             for (auto arg : callext_inst->args) {
                 if (arg->IsConstInt())
                     continue;
-                ReachableType *var_type = new ReachableType(arg->var->type);
-                ReachableType::GetReachableType(program, var_type, args_reachable_types);
+                reachable_types.Union(types.Reachable(arg->var->type));
             }
 
             for (auto v : addr_taken) {
-                if (ReachableType::isPresentInSet(global_reachable_types, new ReachableType(v->type)))
+                int type_id = types.Id(v->type);
+                if (type_id >= 0 && reachable_types.Test(type_id))
                     WDEF.insert(v);
             }
 
-            for (auto v : addr_taken) {
-                if (ReachableType::isPresentInSet(args_reachable_types, new ReachableType(v->type)))
-                    WDEF.insert(v);
-            }
-
-            std::copy(WDEF.begin(), WDEF.end(), std::inserter(USE, USE.end()));
-            
+            USE = names(WDEF);
             for(auto arg : callext_inst->args) {
                 if (!arg->IsConstInt())
-                    USE.insert(arg->var);
-            }
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            for (Variable *v : WDEF) {
-                // sigma_prime[v] = sigma_prime[v] U { pp }
-                sigma_prime[v->name].insert(pp);
+                    USE.insert(arg->var->name);
             }
-
-            if (callext_inst->lhs)
-                sigma_prime[callext_inst->lhs->name] = {pp};
-
+            add(pp, USE, names(WDEF), callext_inst->lhs);
         }
         index += 1;
     }
@@ -549,241 +314,102 @@ void execute(
     Instruction *terminal_instruction = bb->terminal;
 
     std::string pp = bb->label + "." + "term";
-    
+    std::set<std::string> USE;
+
     if ((*terminal_instruction).instrType == InstructionType::JumpInstrType)
     {
         JumpInstruction *jump_inst = (JumpInstruction *) terminal_instruction;
-        std::set<Variable*> USE;
-        std::set<Variable*> DEF;
-
         /*
          * DEF = {}
          * USE = {}
-         * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v] => since USE is empty, no update to soln
         */
-
-        // For target basic block, join bb2store[target] with sigma_prime and add target to worklist if changed
-        if (!execute_final) {
-            bool store_changed = joinAbsStore(bb2store[jump_inst->label], sigma_prime);
-            if (store_changed || bbs_to_output.count(jump_inst->label) == 0) {
-                worklist.push_back(jump_inst->label);
-                bbs_to_output.insert(jump_inst->label);
-            }
-        }
+        add(pp, USE, {}, nullptr);
+        block.succs.push_back(jump_inst->label);
     }
     else if ((*terminal_instruction).instrType == InstructionType::BranchInstrType)
     {
         BranchInstruction *branch_inst = (BranchInstruction *) terminal_instruction;
-
         /*
          * DEF = {}
          * USE = { op | op is a variable }
          * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
         */
-        std::set<Variable*> USE;
-        std::set<Variable*> DEF;
-
         if (!branch_inst->condition->IsConstInt())
-            USE.insert(branch_inst->condition->var);
-
-        if (execute_final) {
-            for (Variable *v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v->name]);
-            }
-        }
-
-        // For target basic block, join bb2store[target] with sigma_prime and add target to worklist if changed
-        if (!execute_final) {
-            
-            bool store_changed_tt = joinAbsStore(bb2store[branch_inst->tt], sigma_prime);
-            bool store_changed_ff = joinAbsStore(bb2store[branch_inst->ff], sigma_prime);
-
-            if (store_changed_tt || bbs_to_output.count(branch_inst->tt) == 0) {
-                worklist.push_back(branch_inst->tt);
-                bbs_to_output.insert(branch_inst->tt);
-            }
-
-            if (store_changed_ff || bbs_to_output.count(branch_inst->ff) == 0) {
-                worklist.push_back(branch_inst->ff);
-                bbs_to_output.insert(branch_inst->ff);
-            }
-        }
+            USE.insert(branch_inst->condition->var->name);
+        add(pp, USE, {}, nullptr);
+        block.succs.push_back(branch_inst->tt);
+        block.succs.push_back(branch_inst->ff);
     }
     else if ((*terminal_instruction).instrType == InstructionType::RetInstrType)
     {
         RetInstruction *ret_inst = (RetInstruction *) terminal_instruction;
-
         /*
          * DEF = {}
          * USE = { op | op is a variable }
          * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
         */
-        std::set<Variable*> USE;
-        std::set<Variable*> DEF;
-
         if (ret_inst->op && !(ret_inst->op->IsConstInt()))
-            USE.insert(ret_inst->op->var);
-        
-        if (execute_final) {
-            for (Variable *v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v->name]);
-            }
-        }
+            USE.insert(ret_inst->op->var->name);
+        add(pp, USE, {}, nullptr);
     }
-    else if ((*terminal_instruction).instrType == InstructionType::CallDirInstrType)
+    else if ((*terminal_instruction).instrType == InstructionType::CallDirInstrType || 
+             (*terminal_instruction).instrType == InstructionType::CallIdrInstrType)
     {
-        CallDirInstruction *calldir_inst = (CallDirInstruction *) terminal_instruction;
-
-        std::set<std::string> CALLEES, REFS, WDEF, REACHABLE, USE;
+        std::set<std::string> CALLEES, REFS, WDEF, REACHABLE;
+        std::vector<Operand*> *args;
+        Variable *lhs;
+        std::string next_bb;
 
         /*
-        * CALLEES = {id} 
+        * CALLEES = {id} for call_dir, pointsTo.PointsTo(fp) for call_idr
         * REACHABLE = globals U all objects reachable from globals or arguments (using points to solution)
         * WDEF = (U mod(c) for all mods of c in CALLEES) ^ REACHABLE
-        * USE = {fp} U {arg | arg is a variable} U ((U ref(c) for all mods of c in CALLEES) ^ REACHABLE)
+        * USE = {fp} U {arg | arg is a variable} U ((U ref(c) for all mods of c in CALLEES) ^ REACHABLE) // fp only for call_idr
         */
-       
-        CALLEES.insert(calldir_inst->callee);
-
-        REACHABLE = GetReachable(calldir_inst->args, pointsTo, program);
-
-        REFS = GetRefs(CALLEES, REACHABLE, modRefInfo);
-		
-        USE.insert(REFS.begin(), REFS.end());
-
-        for(const auto& arg: calldir_inst->args) {
-            if(!arg->IsConstInt()) {
-                USE.insert(arg->var->name);
-            }
+        if ((*terminal_instruction).instrType == InstructionType::CallDirInstrType) {
+            CallDirInstruction *calldir_inst = (CallDirInstruction *) terminal_instruction;
+            CALLEES.insert(calldir_inst->callee);
+            args = &calldir_inst->args;
+            lhs = calldir_inst->lhs;
+            next_bb = calldir_inst->next_bb;
         }
-        WDEF = GetDefs(CALLEES, REACHABLE, modRefInfo);
-
-        // Remove test. prefix from USE, WDEF
-        std::set<std::string> USE_tmp;
-        for (auto u : USE) {
-            if (u.find("test.") != std::string::npos)
-                USE_tmp.insert(u.substr(u.find("test.") + 5));
-            else
-                USE_tmp.insert(u);
-        }
-        USE = USE_tmp;
-
-        std::set<std::string> WDEF_tmp;
-        for (auto w : WDEF) {
-            if (w.find("test.") != std::string::npos)
-                WDEF_tmp.insert(w.substr(w.find("test.") + 5));
-            else
-                WDEF_tmp.insert(w);
-        }
-
-        if (execute_final) {
-            for (std::string v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v]);
+        else {
+            CallIdrInstruction *callidir_inst = (CallIdrInstruction *) terminal_instruction;
+            for(auto pts_to: pointsTo.PointsTo(callidir_inst->fp->key)) {
+                // Remove func_name. from pts_to
+                if (pts_to.find(".") != std::string::npos)
+                    pts_to = pts_to.substr(pts_to.find(".") + 1);
+                CALLEES.insert(pts_to);
             }
+            USE.insert(callidir_inst->fp->name);
+            args = &callidir_inst->args;
+            lhs = callidir_inst->lhs;
+            next_bb = callidir_inst->next_bb;
         }
 
-        for (std::string v : WDEF) {
-            // sigma_prime[v] = sigma_prime[v] U { pp }
-            sigma_prime[v].insert(pp);
-        }
-
-        if (calldir_inst->lhs) {
-            sigma_prime[calldir_inst->lhs->name] = {pp};
-        }
-
-        if (!execute_final) {
-            if (joinAbsStore(bb2store[calldir_inst->next_bb], sigma_prime) || bbs_to_output.count(calldir_inst->next_bb) == 0) {
-                worklist.push_back(calldir_inst->next_bb);
-                bbs_to_output.insert(calldir_inst->next_bb);
-            }
-        }
-
-    }
-    else if ((*terminal_instruction).instrType == InstructionType::CallIdrInstrType)
-    {
-        CallIdrInstruction *callidir_inst = (CallIdrInstruction *) terminal_instruction;
-
-        std::set<std::string> CALLEES, REFS, WDEF, REACHABLE, USE;
-        /*
-        * CALLEES = pointsTo[fp]
-        * REACHABLE = globals U all objects reachable from globals or arguments (using points to solution)
-        * WDEF = (U mod(c) for all mods of c in CALLEES) ^ REACHABLE
-        * USE = {fp} U {arg | arg is a variable} U ((U ref(c) for all mods of c in CALLEES) ^ REACHABLE)
-        */
-
-        // Add function name to callidir_inst->fp->name
-        std::string pointsToVarName = isGlobalVar(callidir_inst->fp, program, "test") ? callidir_inst->fp->name : "test." + callidir_inst->fp->name;
-        for(auto pts_to: pointsTo[pointsToVarName]) {
-            // Remove func_name. from pts_to
-            if (pts_to.find(".") != std::string::npos)
-                pts_to = pts_to.substr(pts_to.find(".") + 1);
-            CALLEES.insert(pts_to);
-        }
-
-        REACHABLE = GetReachable(callidir_inst->args, pointsTo, program);
+        REACHABLE = GetReachable(*args, pointsTo, program);
 
         REFS = GetRefs(CALLEES, REACHABLE, modRefInfo);
-		
         USE.insert(REFS.begin(), REFS.end());
 
-        USE.insert(callidir_inst->fp->name);
-
-        for(const auto& arg: callidir_inst->args) {
+        for(const auto& arg: *args) {
             if(!arg->IsConstInt()) {
                 USE.insert(arg->var->name);
             }
         }
         WDEF = GetDefs(CALLEES, REACHABLE, modRefInfo);
 
-        // Remove test. prefix from USE, WDEF
+        // USE holds the locals of func by name; the weak definitions keep the points-to names
         std::set<std::string> USE_tmp;
-        for (auto u : USE) {
-            if (u.find("test.") != std::string::npos)
-                USE_tmp.insert(u.substr(u.find("test.") + 5));
-            else
-                USE_tmp.insert(u);
-        }
-        USE = USE_tmp;
-
-        std::set<std::string> WDEF_tmp;
-        for (auto w : WDEF) {
-            if (w.find("test.") != std::string::npos)
-                WDEF_tmp.insert(w.substr(w.find("test.") + 5));
-            else
-                WDEF_tmp.insert(w);
-        }
-
-        if (execute_final) {
-            for (std::string v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v]);
-            }
-        }
-
-        for (std::string v : WDEF) {
-            // sigma_prime[v] = sigma_prime[v] U { pp }
-            sigma_prime[v].insert(pp);
-        }
-
-        if (callidir_inst->lhs)
-        {
-            sigma_prime[callidir_inst->lhs->name] = {pp};
-        }
-
-        if (!execute_final) {
-            if (joinAbsStore(bb2store[callidir_inst->next_bb], sigma_prime) || bbs_to_output.count(callidir_inst->next_bb) == 0) {
-                worklist.push_back(callidir_inst->next_bb);
-                bbs_to_output.insert(callidir_inst->next_bb);
-            }
-        }
+        for (const auto& u : USE)
+            USE_tmp.insert(LocalName(u, func));
 
+        add(pp, USE_tmp, WDEF, lhs);
+        block.succs.push_back(next_bb);
     }
     else
     {
         std::cout << "Unknown terminal instruction type" << std::endl;
     }
-    return;
-}
\ No newline at end of file
+    return block;
+}
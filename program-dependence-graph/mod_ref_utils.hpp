@@ -1,20 +1,29 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <sstream>
 #include <string>
 #include <queue>
 #include<set>
+#include <random>
+#include <unordered_map>
+#include <vector>
 #include "../headers/datatypes.h"
+#include "../headers/points_to_index.hpp"
+#include "../headers/bit_vector.hpp"
 
 class Node {
     public:
     std::string name;
-    std::set<Node*> preds, succs;
-    std::set<std::string> mods;
-    std::set<std::string> refs;
+    std::vector<int> succs;         // callees, by node id
+    std::vector<int> mods, refs;    // abstract locations the function itself defines / references, by location id
+    int scc = -1;                   // SCC of the call graph, numbered bottom-up
     Node(std::string name) : name(name) {}
 };
 
@@ -23,11 +32,13 @@ class Node {
 * 1. Compute the call graph:
 *   a. Node for each function
 *   b. Edge from function A to function B if A calls B
-* 2. Compute the transitive closure of the call graph
+* 2. Condense the call graph into its strongly connected components
 * 3. Initialize mod/ref information: For each function compute:
 *   a. The set of globals assigned in the function and pointed to objects that function F can define i.e store operations
 *   b. The set of globals read in the function and pointed to objects that function F can reference i.e load operations
-* 4. Propagate mod/ref information: For each function F, propagate the mod/ref information backwards in the transitive closure of the call graph
+* 4. Propagate mod/ref information bottom-up over the SCCs: the mods/refs of F are its own and those of every
+*    function it can transitively call, i.e. those of its SCC and of the SCCs it calls
+* Abstract locations are numbered so the propagation unions bit-vectors, and it touches every call edge once.
 */
 
 class ModRefInfo {
@@ -38,42 +49,72 @@ class ModRefInfo {
 class ModRef {
     private:
     Program program_;
-    std::unordered_map<std::string, std::set<std::string>> pointsTo;
-    std::unordered_map<std::string, Node*> nodes_;
+    const PointsToIndex& pointsTo;
+    std::vector<std::string> roots_;
+    std::vector<Node*> nodes_;
+    std::unordered_map<std::string, int> node_ids_;
+    std::vector<std::string> locs_;                  // location id -> abstract location
+    std::unordered_map<std::string, int> loc_ids_;
+    int num_sccs_ = 0;
 
     Node* get_node(std::string name) {
-        if (nodes_.find(name) == nodes_.end()) {
-            nodes_[name] = new Node(name);
+        return nodes_[get_node_id(name)];
+    }
+
+    int get_node_id(const std::string &name) {
+        auto [it, inserted] = node_ids_.try_emplace(name, nodes_.size());
+        if (inserted) {
+            nodes_.push_back(new Node(name));
+        }
+        return it->second;
+    }
+
+    int get_loc_id(const std::string &loc) {
+        auto [it, inserted] = loc_ids_.try_emplace(loc, locs_.size());
+        if (inserted) {
+            locs_.push_back(loc);
+        }
+        return it->second;
+    }
+
+    void AddMod(Node *node, const std::string &loc) {
+        node->mods.push_back(get_loc_id(loc));
+    }
+
+    void AddRef(Node *node, const std::string &loc) {
+        node->refs.push_back(get_loc_id(loc));
+    }
+
+    void AddCall(Node *node, const std::string &callee) {
+        int callee_id = get_node_id(callee);
+        if (std::find(node->succs.begin(), node->succs.end(), callee_id) == node->succs.end()) {
+            node->succs.push_back(callee_id);
         }
-        return nodes_[name];
     }
     
     void ComputeCallGraph() {
 
-        // Add edges to the call graph
-        // Start from test function since that is always the function we need to analyze
+        // Add edges to the call graph, for the functions reachable from the roots
         std::queue<std::string> to_visit;
-        to_visit.push("test");
         std::set<std::string> visited;
-        visited.insert("test");
+        for (const auto &root: roots_) {
+            if (visited.insert(root).second)
+                to_visit.push(root);
+        }
 
         while (!to_visit.empty()) {
             std::string func_name = to_visit.front();
             to_visit.pop();
-            Function *func = program_.funcs[func_name];
+            auto func_it = program_.funcs.find(func_name);
+            if (func_it == program_.funcs.end())
+                continue;
+            Function *func = func_it->second;
             Node *node = get_node(func_name);
 
             for (auto &bb: func->bbs) {
                 if (bb.second->terminal->instrType == InstructionType::CallDirInstrType) {
                     CallDirInstruction *call_instr = (CallDirInstruction *)bb.second->terminal;
-                    Node *callee_node = get_node(call_instr->callee);
-                    // Check that callee_node is not already added to the set of successors of node
-                    if (node->succs.find(callee_node) == node->succs.end()) {
-                        node->succs.insert(callee_node);
-                    }
-                    if (callee_node->preds.find(node) == callee_node->preds.end()) {
-                        callee_node->preds.insert(node);
-                    }
+                    AddCall(node, call_instr->callee);
                     if (visited.find(call_instr->callee) == visited.end()) {
                         to_visit.push(call_instr->callee);
                         visited.insert(call_instr->callee);
@@ -82,15 +123,9 @@ class ModRef {
   
                 else if (bb.second->terminal->instrType == InstructionType::CallIdrInstrType) {
                     CallIdrInstruction *call_instr = (CallIdrInstruction *)bb.second->terminal;
-                    std::set<std::string> callees = pointsTo[call_instr->fp->name];
+                    PointsToIndex::Targets callees = pointsTo.PointsTo(call_instr->fp->name);
                     for (auto &callee: callees) {
-                        Node *callee_node = get_node(callee);
-                        if (node->succs.find(callee_node) == node->succs.end()) {
-                            node->succs.insert(callee_node);
-                        }
-                        if (callee_node->preds.find(node) == callee_node->preds.end()) {
-                            callee_node->preds.insert(node);
-                        }
+                        AddCall(node, callee);
                         if (visited.find(callee) == visited.end()) {
                             to_visit.push(callee);
                             visited.insert(callee);
@@ -102,57 +137,109 @@ class ModRef {
     }
 
     /*
-    * Compute transitive closure of the call graph
-    * if there is a path from A to B and B to C, then there is a path from A to C
+    * Number the SCCs of the call graph bottom-up, callees before callers
+    * Iterative Tarjan's algorithm, which emits every SCC after all the SCCs it can reach.
     */
-    void ComputeTransitiveClosure() {
-        std::queue<std::string> worklist;
-        std::set<std::string> visited;
+    void ComputeSCCs() {
+        std::vector<int> index(nodes_.size(), -1), lowlink(nodes_.size(), 0);
+        std::vector<bool> on_stack(nodes_.size(), false);
+        std::vector<int> stack;
+        int next_index = 0;
 
-        worklist.push("test");
-        visited.insert("test");
+        for (int root = 0; root < nodes_.size(); root++) {
+            if (index[root] != -1)
+                continue;
 
-        while (!worklist.empty())
-        {
-            std::string func_name = worklist.front();
-            worklist.pop();
+            // Each frame holds a node and the position of the next callee to visit
+            std::vector<std::pair<int, int>> call_stack;
+            index[root] = lowlink[root] = next_index++;
+            stack.push_back(root);
+            on_stack[root] = true;
+            call_stack.push_back({root, 0});
 
-            Node *node = get_node(func_name);
-            for (auto &succ: node->succs) {
-                int succ_edges = succ->preds.size() + succ->succs.size();
-                if (node->name != succ->name) {
-                    for (auto &pred: node->preds) {
-                        int pred_edges = pred->preds.size() + pred->succs.size();
-                            if (pred->succs.find(succ) == pred->succs.end()) {
-                                pred->succs.insert(succ);
-                            }
-                            if (succ->preds.find(pred) == succ->preds.end()) {
-                                succ->preds.insert(pred);
-                            }
-                        if (visited.find(pred->name) == visited.end() || pred->preds.size() + pred->succs.size() > pred_edges) {
-                            worklist.push(pred->name);
-                            visited.insert(pred->name);
-                        }
+            while (!call_stack.empty()) {
+                int node = call_stack.back().first;
+                int next = call_stack.back().second;
+
+                if (next < nodes_[node]->succs.size()) {
+                    int succ = nodes_[node]->succs[next];
+                    call_stack.back().second += 1;
+                    if (index[succ] == -1) {
+                        index[succ] = lowlink[succ] = next_index++;
+                        stack.push_back(succ);
+                        on_stack[succ] = true;
+                        call_stack.push_back({succ, 0});
+                    }
+                    else if (on_stack[succ]) {
+                        lowlink[node] = std::min(lowlink[node], index[succ]);
                     }
+                    continue;
                 }
-                if (visited.find(succ->name) == visited.end() || succ->preds.size() + succ->succs.size() > succ_edges) {
-                    worklist.push(succ->name);
-                    visited.insert(succ->name);
+
+                // All callees visited - pop the SCC if node is its root
+                if (lowlink[node] == index[node]) {
+                    int member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        on_stack[member] = false;
+                        nodes_[member]->scc = num_sccs_;
+                    } while (member != node);
+                    num_sccs_ += 1;
+                }
+                call_stack.pop_back();
+                if (!call_stack.empty()) {
+                    int parent = call_stack.back().first;
+                    lowlink[parent] = std::min(lowlink[parent], lowlink[node]);
                 }
             }
         }
     }
 
+    /*
+     * Version of the summaries written to the cache, part of every key
+     * Bump it whenever the mod/ref analysis changes, so entries written by older code are never read back.
+     */
+    static constexpr const char *kCacheVersion = "modref-2";
+
+    /*
+     * 64 bit FNV-1a hash of the cache version, the program, the points-to solution and the roots, in hex
+     */
+    std::string CacheKey(const std::string &program_text) const {
+        uint64_t hash = 14695981039346656037ULL;
+        auto add = [&](const std::string &str) {
+            for (unsigned char c : str) {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            // Separator, so that ("ab", "c") and ("a", "bc") hash differently
+            hash ^= 0xff;
+            hash *= 1099511628211ULL;
+        };
+        add(kCacheVersion);
+        add(program_text);
+        for (int id = 0; id < pointsTo.NumNames(); id++) {
+            if (!pointsTo.Contains(pointsTo.Name(id)))
+                continue;
+            add(pointsTo.Name(id));
+            for (const auto &target: pointsTo.PointsTo(id))
+                add(target);
+            add("->");
+        }
+        for (const auto &root: roots_)
+            add(root);
+
+        std::ostringstream key;
+        key << std::hex << hash;
+        return key.str();
+    }
+
     bool isGlobalVar(Variable *var, std::string func_name) {
-    
+        if (var->scope != VarScope::Unknown)
+            return var->IsGlobal();
         if (program_.funcs[func_name]->locals.count(var->name) > 0)
             return false;
-
-        for (auto gl : program_.globals) {
-            if (gl->globalVar->name == var->name)
-                return true;
-        }
-        return false;
+        return program_.global_names.count(var->name) > 0;
     }
 
     /*
@@ -168,60 +255,60 @@ class ModRef {
                 for (auto &instr: bb.second->instructions) {
                     if (instr->instrType == InstructionType::StoreInstrType) {
                         StoreInstruction *store_instr = (StoreInstruction *)instr;
-                        // Add func name while comparing with pts to set for locals and keep it as is for globals
-                        std::string pointsToKey = isGlobalVar(store_instr->dst, it.second->name) ? store_instr->dst->name : it.second->name + "." + store_instr->dst->name;
-                        if (pointsTo.count(pointsToKey)) {
-                            for (auto pointed_to: pointsTo[pointsToKey]) {
-                                node->mods.insert(pointed_to);
+                        // Points-to key resolved at load time: func.name for locals, the bare name for globals
+                        std::string pointsToKey = store_instr->dst->key;
+                        if (pointsTo.Contains(pointsToKey)) {
+                            for (auto pointed_to: pointsTo.PointsTo(pointsToKey)) {
+                                AddMod(node, pointed_to);
                             }
                         }
 
                         // If rhs is global, add to set of refs
                         if (isGlobalVar(store_instr->dst, it.second->name)) {
-                            node->refs.insert(store_instr->dst->name);
+                            AddRef(node, store_instr->dst->name);
                         }
                         if (!store_instr->op->IsConstInt() && isGlobalVar(store_instr->op->var, it.second->name)) {
-                            node->refs.insert(store_instr->op->var->name);
+                            AddRef(node, store_instr->op->var->name);
                         }
                     }
                     else if (instr->instrType == InstructionType::LoadInstrType) {
                         LoadInstruction *load_instr = (LoadInstruction *)instr;
-                        // Add func name while comparing with pts to set for locals and keep it as is for globals
-                        std::string pointsToKey = isGlobalVar(load_instr->src, it.second->name) ? load_instr->src->name : it.second->name + "." + load_instr->src->name;
-                        if (pointsTo.count(pointsToKey)) {
-                            for (auto pointed_to: pointsTo[pointsToKey]) {
-                                node->refs.insert(pointed_to);
+                        // Points-to key resolved at load time: func.name for locals, the bare name for globals
+                        std::string pointsToKey = load_instr->src->key;
+                        if (pointsTo.Contains(pointsToKey)) {
+                            for (auto pointed_to: pointsTo.PointsTo(pointsToKey)) {
+                                AddRef(node, pointed_to);
                             }
                         }
 
                         // If lhs is global, add to set of mods
                         if (isGlobalVar(load_instr->lhs, it.second->name)) {
-                            node->mods.insert(load_instr->lhs->name);
+                            AddMod(node, load_instr->lhs->name);
                         }
                     }
                     else if (instr->instrType == InstructionType::CopyInstrType) {
                         CopyInstruction *copy_instr = (CopyInstruction *)instr;
                         // If the lhs is a global, then add to set of mods
                         if (isGlobalVar(copy_instr->lhs, it.second->name)) {
-                            node->mods.insert(copy_instr->lhs->name);
+                            AddMod(node, copy_instr->lhs->name);
                         }
                         // If the rhs is a global, then add to set of refs
                         if (!copy_instr->op->IsConstInt() && isGlobalVar(copy_instr->op->var, it.second->name)) {
-                            node->refs.insert(copy_instr->op->var->name);
+                            AddRef(node, copy_instr->op->var->name);
                         }
                     }
                     else if (instr->instrType == InstructionType::ArithInstrType) {
                         ArithInstruction *arith_instr = (ArithInstruction *)instr;
                         // If the lhs is a global, then add to set of mods
                         if (isGlobalVar(arith_instr->lhs, it.second->name)) {
-                            node->mods.insert(arith_instr->lhs->name);
+                            AddMod(node, arith_instr->lhs->name);
                         }
                         // If the rhs is a global, then add to set of refs
                         if (!arith_instr->op1->IsConstInt() && isGlobalVar(arith_instr->op1->var, it.second->name)) {
-                            node->refs.insert(arith_instr->op1->var->name);
+                            AddRef(node, arith_instr->op1->var->name);
                         }
                         if (!arith_instr->op2->IsConstInt() && isGlobalVar(arith_instr->op2->var, it.second->name)) {
-                            node->refs.insert(arith_instr->op2->var->name);
+                            AddRef(node, arith_instr->op2->var->name);
                         }
                     }
                     else if (instr->instrType == InstructionType::AllocInstrType)
@@ -229,58 +316,58 @@ class ModRef {
                         AllocInstruction *alloc_instr = (AllocInstruction *)instr;
                         // If the lhs is a global, then add to set of mods
                         if (isGlobalVar(alloc_instr->lhs, it.second->name)) 
-                            node->mods.insert(alloc_instr->lhs->name);
+                            AddMod(node, alloc_instr->lhs->name);
                         // If the rhs is a global, then add to set of refs
                         if (!alloc_instr->num->IsConstInt() && isGlobalVar(alloc_instr->num->var, it.second->name)) 
-                            node->refs.insert(alloc_instr->num->var->name);
+                            AddRef(node, alloc_instr->num->var->name);
                     }
                     else if (instr->instrType == InstructionType::CmpInstrType)
                     {
                         CmpInstruction *cmp_instr = (CmpInstruction *)instr;
                         // If the lhs is a global, then add to set of mods
                         if (isGlobalVar(cmp_instr->lhs, it.second->name)) 
-                            node->mods.insert(cmp_instr->lhs->name);
+                            AddMod(node, cmp_instr->lhs->name);
                         // If the rhs is a global, then add to set of refs
                         if (!cmp_instr->op1->IsConstInt() && isGlobalVar(cmp_instr->op1->var, it.second->name)) 
-                            node->refs.insert(cmp_instr->op1->var->name);
+                            AddRef(node, cmp_instr->op1->var->name);
                         if (!cmp_instr->op2->IsConstInt() && isGlobalVar(cmp_instr->op2->var, it.second->name)) 
-                            node->refs.insert(cmp_instr->op2->var->name);
+                            AddRef(node, cmp_instr->op2->var->name);
                     }
                     else if (instr->instrType == InstructionType::GepInstrType)
                     {
                         GepInstruction *gep_instr = (GepInstruction *)instr;
                         // If the lhs is a global, then add to set of mods
                         if (isGlobalVar(gep_instr->lhs, it.second->name)) 
-                            node->mods.insert(gep_instr->lhs->name);
+                            AddMod(node, gep_instr->lhs->name);
                         // If the rhs is a global, then add to set of refs
                         if (isGlobalVar(gep_instr->src, it.second->name)) 
-                            node->refs.insert(gep_instr->src->name);
+                            AddRef(node, gep_instr->src->name);
                         if (!gep_instr->idx->IsConstInt() && isGlobalVar(gep_instr->idx->var, it.second->name)) 
-                            node->refs.insert(gep_instr->idx->var->name);
+                            AddRef(node, gep_instr->idx->var->name);
                     }
                     else if (instr->instrType == InstructionType::GfpInstrType)
                     {
                         GfpInstruction *gfp_instr = (GfpInstruction *)instr;
                         // If the lhs is a global, then add to set of mods
                         if (isGlobalVar(gfp_instr->lhs, it.second->name)) 
-                            node->mods.insert(gfp_instr->lhs->name);
+                            AddMod(node, gfp_instr->lhs->name);
                         // If the rhs is a global, then add to set of refs
                         if (isGlobalVar(gfp_instr->src, it.second->name)) 
-                            node->refs.insert(gfp_instr->src->name);
+                            AddRef(node, gfp_instr->src->name);
                     }
                     else if (instr->instrType == InstructionType::AddrofInstrType)
                     {
                         AddrofInstruction *addrof_instr = (AddrofInstruction *)instr;
                         // If the lhs is a global, then add to set of mods
                         if (isGlobalVar(addrof_instr->lhs, it.second->name)) 
-                            node->mods.insert(addrof_instr->lhs->name);
+                            AddMod(node, addrof_instr->lhs->name);
                     }
                     else if (instr->instrType == InstructionType::RetInstrType)
                     {
                         // IF op is a global, add to set of refs
                         RetInstruction *ret_instr = (RetInstruction *)instr;
                         if (!ret_instr->op->IsConstInt() && isGlobalVar(ret_instr->op->var, it.second->name)) 
-                            node->refs.insert(ret_instr->op->var->name);
+                            AddRef(node, ret_instr->op->var->name);
                     }
                 }
             }
@@ -289,15 +376,11 @@ class ModRef {
 
     void PrintNodes() {
         std::cout << std::endl;
-        for(const auto& [func_name, func_ref]: nodes_) {
-            std::cout << "Node " << func_name << std::endl;
-            std::cout << "Predecessors: " << std::endl;
-            for(const auto& node: func_ref->preds) {
-                std::cout << node->name << std::endl;
-            }
+        for(const auto& node: nodes_) {
+            std::cout << "Node " << node->name << " (SCC " << node->scc << ")" << std::endl;
             std::cout << "Successors: " << std::endl;
-            for(const auto& node: func_ref->succs) {
-                std::cout << node->name << std::endl;
+            for(int succ: node->succs) {
+                std::cout << nodes_[succ]->name << std::endl;
             }
             std::cout << std::endl;
         }
@@ -322,27 +405,96 @@ class ModRef {
     public:
     std::map<std::string, ModRefInfo> mod_ref_info;
 
-    ModRef(Program program, std::unordered_map<std::string, std::set<std::string>> pointsTo) : program_(program), pointsTo(pointsTo) {}
+    /*
+     * Call edges are followed from roots, or from every function if roots is empty
+     */
+    ModRef(Program program, const PointsToIndex& pointsTo, std::vector<std::string> roots) : program_(program), pointsTo(pointsTo), roots_(roots) {
+        if (roots_.empty()) {
+            for (const auto &[func_name, func]: program_.funcs)
+                roots_.push_back(func_name);
+            std::sort(roots_.begin(), roots_.end());
+        }
+    }
+
+    /*
+     * Mod/ref summaries cached on disk
+     * The summaries only depend on the program, the points-to solution and the roots, so they are stored in
+     * cache_dir under a hash of the three and a later run with the same inputs reads them back instead of
+     * recomputing them. program_text is the program in a canonical form (e.g. its parsed json dumped back).
+     */
+    std::map<std::string, ModRefInfo> ComputeModRefInfo(const std::string &cache_dir, const std::string &program_text) {
+        std::string path = cache_dir + "/" + CacheKey(program_text) + ".modref.json";
+        std::ifstream in(path);
+        if (in) {
+            try {
+                json cached = json::parse(in);
+                for (auto &[func_name, info]: cached.items()) {
+                    mod_ref_info[func_name].mod = info.at("mod").get<std::set<std::string>>();
+                    mod_ref_info[func_name].ref = info.at("ref").get<std::set<std::string>>();
+                }
+                return mod_ref_info;
+            }
+            catch (const json::exception &e) {
+                // A truncated or stale entry is recomputed and overwritten below
+                mod_ref_info.clear();
+            }
+        }
+
+        ComputeModRefInfo();
+
+        json cached = json::object();
+        for (const auto &[func_name, info]: mod_ref_info) {
+            cached[func_name] = {{"mod", info.mod}, {"ref", info.ref}};
+        }
+        // Write to a temporary file first so a concurrent run never reads a partial entry
+        std::string tmp_path = path + "." + std::to_string(std::random_device()()) + ".tmp";
+        std::ofstream out(tmp_path);
+        if (!out) {
+            std::cerr << "Could not write mod/ref cache entry " << path << std::endl;
+            return mod_ref_info;
+        }
+        out << cached.dump();
+        out.close();
+        std::rename(tmp_path.c_str(), path.c_str());
+        return mod_ref_info;
+    }
 
     std::map<std::string, ModRefInfo> ComputeModRefInfo() {
 
         ComputeCallGraph();
-        //PrintNodes();
-        //std::cout << "Transitive closure" << std::endl;
-        ComputeTransitiveClosure();
-        //PrintNodes();
         InitModRefInfo();
+        ComputeSCCs();
+        //PrintNodes();
+
+        // Members of an SCC by SCC, which come bottom-up
+        std::vector<std::vector<int>> members(num_sccs_);
+        for (int id = 0; id < nodes_.size(); id++) {
+            members[nodes_[id]->scc].push_back(id);
+        }
 
-        // Propagate mod/ref information backwards in the transitive closure of the call graph
-        for(const auto& [func_name, func_ref]: nodes_) {
-            for(const auto& node: func_ref->succs) {
-                func_ref->refs.insert(node->refs.begin(), node->refs.end());
-                func_ref->mods.insert(node->mods.begin(), node->mods.end());
+        // Propagate mod/ref information bottom-up: an SCC gets the mods/refs of its members and of its callees
+        std::vector<BitVector> scc_mods(num_sccs_, BitVector(locs_.size())), scc_refs(num_sccs_, BitVector(locs_.size()));
+        for (int scc = 0; scc < num_sccs_; scc++) {
+            for (int id : members[scc]) {
+                Node *node = nodes_[id];
+                for (int loc : node->mods)
+                    scc_mods[scc].Set(loc);
+                for (int loc : node->refs)
+                    scc_refs[scc].Set(loc);
+                for (int succ : node->succs) {
+                    int callee_scc = nodes_[succ]->scc;
+                    if (callee_scc != scc) {
+                        scc_mods[scc].Union(scc_mods[callee_scc]);
+                        scc_refs[scc].Union(scc_refs[callee_scc]);
+                    }
+                }
             }
+        }
 
-            mod_ref_info[func_name] = {};
-            mod_ref_info[func_name].mod = func_ref->mods;
-            mod_ref_info[func_name].ref = func_ref->refs;
+        for (auto node : nodes_) {
+            ModRefInfo &info = mod_ref_info[node->name];
+            scc_mods[node->scc].ForEach([&](int loc) { info.mod.insert(locs_[loc]); });
+            scc_refs[node->scc].ForEach([&](int loc) { info.ref.insert(locs_[loc]); });
         }
 
         //std::cout << "Mod Ref Info" << std::endl;
@@ -350,4 +502,4 @@ class ModRef {
 
         return mod_ref_info;
     }
-};
+};
\ No newline at end of file
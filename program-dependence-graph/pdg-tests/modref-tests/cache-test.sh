@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Checks that a --modref-cache miss and the following hit slice test.3 the same way
+# usage: ./cache-test.sh <path to assn4_program_slicing>
+
+# exit when any command fails
+set -e
+
+slicer=$(realpath "$1")
+cd "$(dirname "$0")"
+cache_dir=$(mktemp -d)
+trap 'rm -rf "$cache_dir"' EXIT
+
+echo "------------------------- Cache miss -------------------------"
+"$slicer" test.3.lir test.3.lir.json main#exit#term ptsto.test.3 --modref-cache "$cache_dir" > "$cache_dir/miss.output"
+if [ "$(ls "$cache_dir"/*.modref.json | wc -l)" -ne 1 ]; then
+    echo "expected exactly one cache entry in $cache_dir"
+    exit 1
+fi
+diff test.3.lir.output "$cache_dir/miss.output"
+
+echo "------------------------- Cache hit -------------------------"
+"$slicer" test.3.lir test.3.lir.json main#exit#term ptsto.test.3 --modref-cache "$cache_dir" > "$cache_dir/hit.output"
+diff "$cache_dir/miss.output" "$cache_dir/hit.output"
+echo "------------------------- Cache outputs match -------------------------"
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../headers/datatypes.h"
+
+/*
+ * Program dependence graph of a function
+ * Every program point of the function is a node, numbered by block label and then by index with the terminal
+ * last, so sorting node ids sorts program points the way slices are printed. The edges are collected as
+ * (from, to) pairs while the dependencies are added and Finalize stores them in CSR form, one array of
+ * predecessors and one of successors per kind of dependence.
+*/
+class PDG {
+    public:
+
+    /*
+     * CSR adjacency: the neighbours of node v are targets[offsets[v] .. offsets[v + 1]), sorted
+     */
+    struct Edges {
+        std::vector<int> offsets;
+        std::vector<int> targets;
+
+        struct Range {
+            const int *first, *last;
+            const int* begin() const { return first; }
+            const int* end() const { return last; }
+        };
+
+        Range Of(int v) const {
+            return {targets.data() + offsets[v], targets.data() + offsets[v + 1]};
+        }
+
+        static Edges Build(int num_nodes, std::vector<std::pair<int, int>> &edges) {
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+            Edges csr;
+            csr.offsets.assign(num_nodes + 1, 0);
+            csr.targets.reserve(edges.size());
+            for (const auto &[from, to] : edges) {
+                csr.offsets[from + 1] += 1;
+                csr.targets.push_back(to);
+            }
+            for (int v = 0; v < num_nodes; v++)
+                csr.offsets[v + 1] += csr.offsets[v];
+            return csr;
+        }
+    };
+
+    PDG(Function *func) : func_(func) {
+        std::vector<std::string> labels;
+        for (const auto &[label, bb] : func->bbs)
+            labels.push_back(label);
+        std::sort(labels.begin(), labels.end());
+
+        for (int b = 0; b < labels.size(); b++) {
+            BasicBlock *bb = func->bbs.at(labels[b]);
+            block_ids_[labels[b]] = b;
+            block_first_.push_back(pp_block_.size());
+            for (int index = 0; index <= bb->instructions.size(); index++) {
+                pp_block_.push_back(bb);
+                pp_index_.push_back(index);
+            }
+        }
+        block_first_.push_back(pp_block_.size());
+    }
+
+    Function* GetFunction() const { return func_; }
+
+    int NumPPs() const { return pp_block_.size(); }
+
+    BasicBlock* Block(int pp) const { return pp_block_[pp]; }
+
+    // Index of pp in its block, the number of instructions for the terminal
+    int Index(int pp) const { return pp_index_[pp]; }
+
+    bool IsTerminal(int pp) const { return pp_index_[pp] == pp_block_[pp]->instructions.size(); }
+
+    Instruction* GetInstruction(int pp) const {
+        return IsTerminal(pp) ? pp_block_[pp]->terminal : pp_block_[pp]->instructions[pp_index_[pp]];
+    }
+
+    /*
+     * Node of the program point at index of block label, index being a number or "term"; -1 if there is none
+     */
+    int GetId(const std::string &label, const std::string &index) const {
+        auto it = block_ids_.find(label);
+        if (it == block_ids_.end())
+            return -1;
+        int first = block_first_[it->second];
+        int size = block_first_[it->second + 1] - first;
+        if (index == "term")
+            return first + size - 1;
+        if (index.empty() || index.find_first_not_of("0123456789") != std::string::npos || index.size() > 9)
+            return -1;
+        int i = std::stoi(index);
+        return i < size - 1 ? first + i : -1;
+    }
+
+    /*
+     * Node of a program point func#bb#index of this function; -1 if there is none
+     */
+    int GetId(const std::string &pp) const {
+        size_t first_sep = pp.find('#');
+        size_t last_sep = pp.rfind('#');
+        if (first_sep == std::string::npos || first_sep == last_sep || pp.substr(0, first_sep) != func_->name)
+            return -1;
+        return GetId(pp.substr(first_sep + 1, last_sep - first_sep - 1), pp.substr(last_sep + 1));
+    }
+
+    std::string GetPP(int pp) const {
+        return func_->name + "#" + pp_block_[pp]->label + "#" + (IsTerminal(pp) ? "term" : std::to_string(pp_index_[pp]));
+    }
+
+    /*
+     * Control dependencies: controlled block -> blocks whose terminal decides whether it runs
+     * Adds an edge from the terminal of each controller to every program point of the controlled block.
+     */
+    void AddControlDependencies(const std::map<std::string, std::set<std::string>> &control_dependencies) {
+        for (const auto &[controlled, controllers] : control_dependencies) {
+            auto to_block = block_ids_.find(controlled);
+            if (to_block == block_ids_.end())
+                continue;
+            for (const auto &controller : controllers) {
+                auto from_block = block_ids_.find(controller);
+                if (from_block == block_ids_.end())
+                    continue;
+                int from = block_first_[from_block->second + 1] - 1;
+                for (int to = block_first_[to_block->second]; to < block_first_[to_block->second + 1]; to++)
+                    cd_edges_.push_back({from, to});
+            }
+        }
+    }
+
+    /*
+     * Data dependencies: use bb.index -> the definitions bb.index reaching it
+     * Adds an edge from every definition to the use.
+     */
+    void AddDataDependencies(const std::map<std::string, std::set<std::string>> &data_dependencies) {
+        for (const auto &[use, definitions] : data_dependencies) {
+            int to = GetLocalId(use);
+            if (to < 0)
+                continue;
+            for (const auto &definition : definitions) {
+                int from = GetLocalId(definition);
+                if (from >= 0)
+                    dd_edges_.push_back({from, to});
+            }
+        }
+    }
+
+    /*
+     * Build the CSR arrays from the edges added so far
+     */
+    void Finalize() {
+        std::vector<std::pair<int, int>> reversed;
+        auto reverse = [&](const std::vector<std::pair<int, int>> &edges) {
+            reversed.clear();
+            for (const auto &[from, to] : edges)
+                reversed.push_back({to, from});
+        };
+        reverse(dd_edges_);
+        dd_pred_ = Edges::Build(NumPPs(), reversed);
+        dd_succ_ = Edges::Build(NumPPs(), dd_edges_);
+        reverse(cd_edges_);
+        cd_pred_ = Edges::Build(NumPPs(), reversed);
+        cd_succ_ = Edges::Build(NumPPs(), cd_edges_);
+        dd_edges_ = {};
+        cd_edges_ = {};
+    }
+
+    Edges::Range DataPreds(int pp) const { return dd_pred_.Of(pp); }
+    Edges::Range DataSuccs(int pp) const { return dd_succ_.Of(pp); }
+    Edges::Range ControlPreds(int pp) const { return cd_pred_.Of(pp); }
+    Edges::Range ControlSuccs(int pp) const { return cd_succ_.Of(pp); }
+
+    /*
+    * Print PDG
+    */
+    void PrintPDG() const {
+        auto print = [&](const char *kind, Edges::Range range) {
+            std::cout << kind;
+            for (int other : range)
+                std::cout << GetPP(other) << " ";
+            std::cout << std::endl;
+        };
+        for (int pp = 0; pp < NumPPs(); pp++) {
+            std::cout << "PP: " << GetPP(pp) << std::endl;
+            print("DD Pred: ", DataPreds(pp));
+            print("DD Succ: ", DataSuccs(pp));
+            print("CD Pred: ", ControlPreds(pp));
+            print("CD Succ: ", ControlSuccs(pp));
+        }
+    }
+
+    private:
+
+    // Node of a program point bb.index as the reaching definitions name it
+    int GetLocalId(const std::string &pp) const {
+        size_t sep = pp.rfind('.');
+        if (sep == std::string::npos)
+            return -1;
+        return GetId(pp.substr(0, sep), pp.substr(sep + 1));
+    }
+
+    Function *func_;
+    std::unordered_map<std::string, int> block_ids_;  // label -> block number, in label order
+    std::vector<int> block_first_;                    // block number -> its first node (one past the end at the back)
+    std::vector<BasicBlock*> pp_block_;               // node -> block
+    std::vector<int> pp_index_;                       // node -> index in block
+    std::vector<std::pair<int, int>> dd_edges_, cd_edges_;
+    Edges dd_pred_, dd_succ_, cd_pred_, cd_succ_;
+};
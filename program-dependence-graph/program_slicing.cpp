@@ -7,237 +7,225 @@
 #include<set>
 #include <fstream>
 #include <sstream>
+#include <atomic>
+#include <thread>
 #include "../headers/datatypes.h"
 #include "control_flow_analysis.hpp"
 #include "mod_ref_utils.hpp"
 #include "reachingdef.hpp"
+#include "pdg.hpp"
+#include "../headers/bit_vector.hpp"
 #include "../headers/tokenizer.hpp"
+#include "../pointer-analysis/points_to_pipeline.hpp"
 
 using json = nlohmann::json;
 
 
-class PDGNode {
-    public:
-    std::string program_point;
-    std::set<std::string> dd_pred, dd_succ; // data dependency edges - predecessors and successors
-    std::set<std::string> cd_pred, cd_succ; // control dependency edges - predecessors and successors
-
-    PDGNode(std::string program_point): program_point(program_point) {}
-};
-
-std::unordered_map<std::string, PDGNode*> pdg; // PDG: pp -> PDGNode
 std::unordered_map<string, std::set<string>> pointsTo; // points to info
-
-class PDG {
-    public:
-
-    static std::string GetPP(std::string function, BasicBlock *bb, int idx) {
-        if (idx == bb->instructions.size()) {
-            return function + "#" + bb->label + "#term";
+PointsToIndex pointsToIndex; // read-only index over pointsTo shared by the analyses
+
+/*
+ * Backward slice of the program point slice_pp: every node it depends on, transitively, over data and
+ * control dependence edges, in node id order, which is the order the slice is printed in
+ */
+std::vector<int> GetSlice(const PDG &pdg, int slice_pp) {
+    BitVector visited(pdg.NumPPs());
+    std::vector<int> slice = {slice_pp};
+    visited.Set(slice_pp);
+
+    // slice doubles as the BFS queue, everything before next has been expanded
+    for (size_t next = 0; next < slice.size(); next++) {
+        int pp = slice[next];
+        for (int pred : pdg.DataPreds(pp)) {
+            if (!visited.Test(pred)) {
+                visited.Set(pred);
+                slice.push_back(pred);
+            }
         }
-        return function + "#" + bb->label + "#" + std::to_string(idx);
-    }
-
-    static void ProcessControlDependencies(Function *func, std::map<std::string, std::set<std::string>> control_dependencies) {
-        std::string fname = func->name;
-        
-        for(const auto& [controlled, controllers]: control_dependencies) {
-            
-            BasicBlock *to_bb = func->bbs[controlled];
-            for(const auto& controller: controllers) {
-                BasicBlock *from_bb = func->bbs[controller];
-
-                // Get index of terminal instruction in from_bb
-                int last_idx = from_bb->instructions.size();
-
-                // Get PP corresponding to the last instruction in from_bb
-                std::string from_pp = PDG::GetPP(fname, from_bb, last_idx);
-
-                if(!pdg.count(from_pp)) {
-                    pdg[from_pp] = new PDGNode(from_pp);
-                }
-
-                std::string to_pp = "";
-                
-                // Add edge from from_bb's terminal instruction to each instruction in to_bb
-                for(int i = 0; i < to_bb->instructions.size() + 1; i++) {
-                    to_pp = PDG::GetPP(fname, to_bb, i);
-                    
-                    if(!pdg.count(to_pp)) {
-                        pdg[to_pp] = new PDGNode(to_pp);
-                    }
-
-                    pdg[from_pp]->cd_succ.insert(to_pp);
-                    pdg[to_pp]->cd_pred.insert(from_pp);
-                }
+        for (int pred : pdg.ControlPreds(pp)) {
+            if (!visited.Test(pred)) {
+                visited.Set(pred);
+                slice.push_back(pred);
             }
         }
     }
 
-    /*
-    * Add an edge between uses and defs in the PDG
-    */
-    static void ProcessDataDependencies(Function *func, std::map<std::string, std::set<std::string>> data_dependencies) {
-        for(const auto& [use, definitions]: data_dependencies) {
-            
-            std::string use_pp = func->name + "#" + use;
-            std::replace(use_pp.begin(), use_pp.end(), '.', '#');
-
-            if(!pdg.count(use_pp)) {
-                pdg[use_pp] = new PDGNode(use_pp);
-            }
-            
-            for(const auto& definition: definitions) {
-                std::string definition_pp = func->name + "#" + definition;
-                std::replace(definition_pp.begin(), definition_pp.end(), '.', '#');
-
-                if(!pdg.count(definition_pp)) {
-                    pdg[definition_pp] = new PDGNode(definition_pp);
-                }
+    std::sort(slice.begin(), slice.end());
+    return slice;
+}
 
-                pdg[definition_pp]->dd_succ.insert(use_pp);
-                pdg[use_pp]->dd_pred.insert(definition_pp);
+void PrintSlice(const PDG &pdg, const std::vector<int> &slice, std::ostream &out) {
+    BasicBlock *curr_bb = nullptr;
+    for (int pp : slice) {
+        if (pdg.Block(pp) != curr_bb) {
+            if (curr_bb != nullptr) {
+                out << std::endl;
             }
+            curr_bb = pdg.Block(pp);
+            out << curr_bb->label << ":" << std::endl;
         }
+        out << "  " << pdg.GetInstruction(pp)->ToString() << std::endl;
     }
+    out << std::endl;
+    out << std::endl;
+}
 
-    /*
-    * Print PDG
-    */
-    static void PrintPDG() {
-        for(const auto& [pp, node]: pdg) {
-            std::cout << "PP: " << pp << std::endl;
-            std::cout << "DD Pred: ";
-            for(const auto& pred: node->dd_pred) {
-                std::cout << pred << " ";
-            }
-            std::cout << std::endl;
+/*
+ * PDG of func_name from its control dependencies and the reaching definitions over the shared points-to
+ * solution, type graph and mod/ref summaries
+ */
+PDG BuildPDG(Program &program, const std::string &func_name, const TypeGraph &types,
+             const std::map<std::string, ModRefInfo> &mod_ref_info) {
+    ControlFlowAnalysis constant_analysis = ControlFlowAnalysis(program);
+    std::map<std::string, std::set<std::string>> control_dependencies = constant_analysis.AnalyzeFunc(func_name);
+    ReachingDef reaching_def = ReachingDef(program, types, pointsToIndex, mod_ref_info);
+    std::map<std::string, std::set<std::string>> data_dependencies = reaching_def.AnalyzeFunc(func_name);
 
-            std::cout << "DD Succ: ";
-            for(const auto& succ: node->dd_succ) {
-                std::cout << succ << " ";
-            }
-            std::cout << std::endl;
+    PDG pdg(program.funcs[func_name]);
+    pdg.AddControlDependencies(control_dependencies);
+    pdg.AddDataDependencies(data_dependencies);
+    pdg.Finalize();
+    return pdg;
+}
 
-            std::cout << "CD Pred: ";
-            for(const auto& pred: node->cd_pred) {
-                std::cout << pred << " ";
-            }
-            std::cout << std::endl;
+/*
+ * Answer every slice pp in criteria, one per line, printing "<slice pp>:" and its slice for each in input order
+ * The PDG of each function named by a criterion is built once. Slicing only reads the PDGs, so num_threads
+ * workers answer the criteria concurrently into their own buffers. Criteria that name no program point are
+ * reported on stderr and skipped; returns false if there were any.
+ */
+bool SliceBatch(Program &program, std::istream &criteria, const TypeGraph &types,
+                const std::map<std::string, ModRefInfo> &mod_ref_info, int num_threads) {
+    std::vector<std::string> slice_pps;
+    std::string line;
+    while (std::getline(criteria, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+            continue;
+        slice_pps.push_back(line.substr(first, line.find_last_not_of(" \t\r") - first + 1));
+    }
 
-            std::cout << "CD Succ: ";
-            for(const auto& succ: node->cd_succ) {
-                std::cout << succ << " ";
-            }
-            std::cout << std::endl;
+    std::map<std::string, PDG> pdgs;
+    std::vector<const PDG*> slice_pdgs(slice_pps.size(), nullptr);
+    std::vector<int> slice_ids(slice_pps.size(), -1);
+    bool ok = true;
+    for (int i = 0; i < slice_pps.size(); i++) {
+        std::string func_name = slice_pps[i].substr(0, slice_pps[i].find('#'));
+        if (program.funcs.count(func_name) == 0) {
+            std::cerr << "Unknown function in slice pp: " << slice_pps[i] << std::endl;
+            ok = false;
+            continue;
+        }
+        auto it = pdgs.find(func_name);
+        if (it == pdgs.end())
+            it = pdgs.emplace(func_name, BuildPDG(program, func_name, types, mod_ref_info)).first;
+        slice_ids[i] = it->second.GetId(slice_pps[i]);
+        if (slice_ids[i] < 0) {
+            std::cerr << "Unknown slice pp: " << slice_pps[i] << std::endl;
+            ok = false;
+            continue;
         }
+        slice_pdgs[i] = &it->second;
     }
 
-};
-
-std::vector<std::string> SplitPP(std::string pp) {
-    std::vector<string> res(3);
-    util::Tokenizer tk(pp, {' '}, {"#"}, {});
-    std::vector<std::string> tokens = tk.Tokens();
-    res[0] = util::Tokenizer::Consume(tokens);
-    util::Tokenizer::ConsumeToken(tokens, "#");
-    res[1] = util::Tokenizer::Consume(tokens);
-    util::Tokenizer::ConsumeToken(tokens, "#");
-    res[2] = util::Tokenizer::Consume(tokens);
-    return res;
-}
-
-// Pad PP to ensure correct ordering of instructions in solution
-string PadPP(string pp) {
-  std::vector<string> cmp = SplitPP(pp);
-  while(cmp[2].size() < 4) {
-    cmp[2].insert(0, "0");
-  }
-  string new_pp = cmp[0] + "#" + cmp[1] + "#" + cmp[2];
-  return new_pp;
-}
+    std::vector<std::ostringstream> outputs(slice_pps.size());
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < slice_pps.size(); i = next++) {
+            if (slice_pdgs[i] != nullptr)
+                PrintSlice(*slice_pdgs[i], GetSlice(*slice_pdgs[i], slice_ids[i]), outputs[i]);
+        }
+    };
 
-struct order {
-  bool operator() (std::string a, std::string b) const {
-    std::vector<std::string> cmp1 = SplitPP(a);
-    std::vector<std::string> cmp2 = SplitPP(b);
-    if(cmp1[0] != cmp2[0]) {
-      if(cmp1[0].compare(cmp2[0]) < 0)
-        return true;
-      return false;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_threads; i++) {
+        workers.emplace_back(worker);
     }
-    if(cmp1[1] != cmp2[1]) {
-      if(cmp1[1].compare(cmp2[1]) < 0)
-        return true;
-      return false;
+    for (auto &t : workers) {
+        t.join();
     }
-    if(cmp1[2] != cmp2[2]) {
-      if(cmp1[2].compare(cmp2[2]) < 0)
-        return true;
-      return false;
-    }
-    return false;
-  }
-};
-
-std::set<string, order> GetSlice(string slice_pp) {
-    
-    std::set<string, order> slice = {};
-    slice.insert(PadPP(slice_pp));
-    
-    std::queue<string> to_visit;
-    to_visit.push(slice_pp);
-
-    while(!to_visit.empty()) {
-        string pp = to_visit.front();
-        to_visit.pop();
-
-        //std::cout << "Popped " << pp << std::endl;
-        if(pdg.find(pp) != pdg.end()) {
-            //std::cout << "Found " << pp << std::endl;
-            for(const auto& pred: pdg[pp]->dd_pred) {
-                std::string tmp = PadPP(pred);
-                if(!slice.count(tmp)) {
-                    to_visit.push(pred);
-                    slice.insert(tmp);
-                    //std::cout << "Inserted dd_pred " << tmp << std::endl;
-                }
-            }
 
-            for(const auto& pred: pdg[pp]->cd_pred) {
-                std::string tmp = PadPP(pred);
-                if(!slice.count(tmp)) {
-                    to_visit.push(pred);
-                    slice.insert(tmp);
-                    //std::cout << "Inserted cd_pred " << tmp << std::endl;
-                }
-            }
-        }
+    for (int i = 0; i < slice_pps.size(); i++) {
+        if (slice_pdgs[i] != nullptr)
+            std::cout << slice_pps[i] << ":" << std::endl << outputs[i].str();
     }
-
-    return slice;
+    return ok;
 }
 
 int main(int argc, char const *argv[])
 {
-   if (argc != 5) {
-        std::cerr << "Usage: program_slicing <lir file> <lir json filepath> <slice pp> <points to soln file>" << std::endl;
+    const char* usage = "Usage: program_slicing <lir file> <lir json filepath> <slice pp | --batch> <points to soln file | --solve> "
+                        "[--modref-roots <func,func,... | all>] [--modref-cache <dir>] [--criteria <file>] [--threads <n>]";
+    if (argc < 5) {
+        std::cerr << usage << std::endl;
         return EXIT_FAILURE;
     }
 
+    // --modref-roots are the functions whose callees get mod/ref summaries (all = every function); by default the
+    // sliced function, or every function in --batch mode
+    // --modref-cache reuses the summaries computed by an earlier run on the same program and points-to solution
+    // --batch slices every pp listed in the --criteria file (stdin by default) with --threads workers (0 = one per core)
+    std::vector<std::string> modref_roots;
+    bool modref_roots_set = false;
+    std::string modref_cache;
+    std::string criteria_file;
+    int num_threads = 1;
+    for (int i = 5; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--modref-roots" && i + 1 < argc) {
+            std::string roots = argv[++i];
+            modref_roots.clear();
+            modref_roots_set = true;
+            if (roots != "all") {
+                std::stringstream roots_stream(roots);
+                std::string root;
+                while (std::getline(roots_stream, root, ','))
+                    modref_roots.push_back(root);
+            }
+        }
+        else if (option == "--modref-cache" && i + 1 < argc) {
+            modref_cache = argv[++i];
+        }
+        else if (option == "--criteria" && i + 1 < argc) {
+            criteria_file = argv[++i];
+        }
+        else if (option == "--threads" && i + 1 < argc) {
+            num_threads = std::stoi(argv[++i]);
+            if (num_threads <= 0)
+                num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else {
+            std::cerr << usage << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     std::ifstream f(argv[2]);
     json lir_json = json::parse(f);
 
     std::string slice_pp = argv[3];
-    std::vector<std::string> pp = SplitPP(slice_pp);
-    std::string func_name = pp[0];
-    std::string bb_name = pp[1];
-    std::string idx = pp[2];
-    // std::cout << "Function: " << func_name << " BB: " << bb_name << " Index: " << idx << std::endl;
+    bool batch = slice_pp == "--batch";
+    std::string func_name = slice_pp.substr(0, slice_pp.find('#'));
+    if (!batch && !modref_roots_set)
+        modref_roots = {func_name};
+
+    std::ifstream criteria_stream;
+    if (batch && !criteria_file.empty()) {
+        criteria_stream.open(criteria_file);
+        if (!criteria_stream) {
+            std::cerr << "Cannot read criteria file " << criteria_file << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
 
     std::string pointsToFile = argv[4];
-    std::ifstream in(pointsToFile);
-    std::string input_str(std::istreambuf_iterator<char>{in}, {});
+    // With --solve the points-to solution is computed in-process instead of being read from a file
+    bool solve_points_to = pointsToFile == "--solve";
+    std::string input_str;
+    if (!solve_points_to) {
+        std::ifstream in(pointsToFile);
+        input_str.assign(std::istreambuf_iterator<char>{in}, {});
+    }
 
     util::Tokenizer tk(input_str, {' '}, {"{", "}", "->", ","}, {});
     std::vector<std::string> tokens = tk.Tokens();
@@ -277,44 +265,40 @@ int main(int argc, char const *argv[])
     }
 
     Program program = Program(lir_json);
-    ControlFlowAnalysis constant_analysis = ControlFlowAnalysis(program);
-    std::map<std::string, std::set<std::string>> control_dependencies = constant_analysis.AnalyzeFunc(func_name);
-    PDG::ProcessControlDependencies(program.funcs[func_name], control_dependencies);
-
-    ModRef mod_ref = ModRef(program, pointsTo);
-    mod_ref.ComputeModRefInfo();
-
-    ReachingDef reaching_def = ReachingDef(program, pointsTo, mod_ref.mod_ref_info);
-    std::map<std::string, std::set<std::string>> data_dependencies = reaching_def.AnalyzeFunc(func_name);
+    if (!batch && program.funcs.count(func_name) == 0) {
+        std::cerr << "Unknown function in slice pp: " << slice_pp << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (solve_points_to) {
+        for (auto const& [name, points_to] : pta::ComputePointsTo(program)) {
+            pointsTo[name] = points_to;
+        }
+    }
+    pointsToIndex = PointsToIndex(pointsTo);
+    ModRef mod_ref = ModRef(program, pointsToIndex, modref_roots);
+    if (modref_cache.empty())
+        mod_ref.ComputeModRefInfo();
+    else
+        mod_ref.ComputeModRefInfo(modref_cache, lir_json.dump());
+
+    TypeGraph types(&program);
+
+    if (batch) {
+        std::istream &criteria = criteria_file.empty() ? std::cin : criteria_stream;
+        return SliceBatch(program, criteria, types, mod_ref.mod_ref_info, num_threads) ? 0 : EXIT_FAILURE;
+    }
 
-    PDG::ProcessDataDependencies(program.funcs[func_name], data_dependencies);
+    PDG pdg = BuildPDG(program, func_name, types, mod_ref.mod_ref_info);
+    int slice_id = pdg.GetId(slice_pp);
+    if (slice_id < 0) {
+        std::cerr << "Unknown slice pp: " << slice_pp << std::endl;
+        return EXIT_FAILURE;
+    }
 
-    //PDG::PrintPDG();
+    //pdg.PrintPDG();
 
     // Get slice for given program point
-    std::set<string, order> slice = GetSlice(slice_pp);
-
-    // std::cout << "Slice for pp: " << slice_pp <<  std::endl;
-
-    string curr_bb = "";
-    for(const auto& pp: slice) {
-        std::vector<string> cmp = SplitPP(pp);
-        if(cmp[1] != curr_bb) {
-        if(curr_bb != "") {
-            std::cout << std::endl;
-        }
-        curr_bb = cmp[1];
-        std::cout << curr_bb << ":" << std::endl;
-        }
-        BasicBlock *bb_ptr = program.funcs[cmp[0]]->bbs[curr_bb];
-        if (cmp[2] == "term") {
-            std::cout << "  " << bb_ptr->terminal->ToString() << std::endl;
-        } else {
-            std::cout << "  " << bb_ptr->instructions[std::stoi(cmp[2])]->ToString() << std::endl;
-        }
-    }
-    std::cout << std::endl;
-    std::cout << std::endl;
+    PrintSlice(pdg, GetSlice(pdg, slice_id), std::cout);
 
     return 0;
 }
\ No newline at end of file
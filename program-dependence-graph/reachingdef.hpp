@@ -8,8 +8,9 @@
 #include <unordered_map>
 
 #include "../headers/datatypes.h"
+#include "../headers/points_to_index.hpp"
 #include "execute_rdef.hpp"
-#include "rtype.hpp"
+#include "../headers/type_graph.hpp"
 
 using json = nlohmann::json;
 
@@ -26,7 +27,7 @@ public:
      */
     std::set<std::string> bbs_to_output;
 
-    ReachingDef(Program program, std::unordered_map<std::string, std::set<std::string>> pointsTo, std::map<std::string, ModRefInfo> modRefInfo_) : program(program), pointsTo(pointsTo), modRefInfo_(modRefInfo_)  {};
+    ReachingDef(Program program, const TypeGraph& types, const PointsToIndex& pointsTo, std::map<std::string, ModRefInfo> modRefInfo_) : program(program), types(types), pointsTo(pointsTo), modRefInfo_(modRefInfo_)  {};
 
     /*
     Method to get all pointer typed globals, parameters, locals of the function
@@ -53,14 +54,14 @@ public:
     }
 
     /*
-     * Wrapper function to get reachable types for all ptr typed variables in the function
+     * Union of the reachable types of all ptr typed variables in the function
     */
-    void get_reachable_types(std::unordered_set<Variable*> &PTRS, std::unordered_set<ReachableType*> &reachable_types, Program *program) {
+    BitVector get_reachable_types(std::unordered_set<Variable*> &PTRS) {
+        BitVector reachable_types(types.size());
         for (auto ptr : PTRS) {
-            ReachableType *var_type = new ReachableType(ptr->type);
-            ReachableType::GetReachableType(program, var_type, reachable_types);
+            reachable_types.Union(types.Reachable(ptr->type));
         }
-        return;
+        return reachable_types;
     }
 
     /*
@@ -161,7 +162,6 @@ public:
 
         // data structures required for prep stage
         std::unordered_set<Variable*> addr_taken; // contains all variables that are address taken i.e addrof is used on them
-        std::unordered_set<ReachableType*> reachable_types; // reachable data types from all pointers in the function
         
         // Prep steps:
         
@@ -172,22 +172,29 @@ public:
         std::unordered_set<Variable*> PTRS = get_ptrs(); // Get all pointer typed globals, parameters, locals of the function
 
         // 3. Get reachable types for all ptr typed variables in the function
-        get_reachable_types(PTRS, reachable_types, &program);
+        BitVector reachable_types = get_reachable_types(PTRS); // reachable data types from all pointers in the function
         
-        // 4. Put all fake variables in the address taken set
-        int i=0;
-        std::unordered_set<ReachableType*> types_considered_for_fakes;
-        for (auto rtype : reachable_types) {
-            ReachableType *faketype = new ReachableType(rtype->type, rtype->ptr_type, rtype->indirection);
-            addr_taken.insert(new Variable("fake_var_" + std::to_string(i), (Type*) faketype));
-            i += 1;
-        }
+        // 4. Put the fake variable of every reachable type in the address taken set
+        reachable_types.ForEach([&](int type_id) {
+            addr_taken.insert(types.Fake(type_id));
+        });
 
         /*
             Setup steps
-            1. Initialize the abstract store for 'entry' basic block
-            2. Add 'entry' basic block to worklist
+            1. Compute DEF/USE of every program point, numbering variables and definitions
+            2. Summarize every block by its GEN and KILL sets
+            3. Initialize the abstract store for 'entry' basic block and add it to the worklist
         */
+        std::map<std::string, BlockDefUse> blocks;
+        for (auto [label, bb] : func->bbs) {
+            blocks[label] = GetBlockDefUse(&program, types, pointsTo, modRefInfo_, func, bb, addr_taken, defs);
+        }
+        defs.Finalize();
+        for (auto &[label, block] : blocks) {
+            SummarizeBlock(block, defs);
+        }
+
+        bb2store.try_emplace("entry", defs.NumDefs());
         worklist.push_back("entry");
         bbs_to_output.insert("entry");
 
@@ -195,50 +202,30 @@ public:
         /*
             Worklist algorithm
             1. Pop a basic block from the worklist
-            2. Perform the transfer function on the basic block
-            3. For each successor of the basic block, join the abstract store of the successor with the abstract store of the current basic block
+            2. Apply the block's transfer function OUT = GEN U (IN - KILL)
+            3. For each successor of the basic block, join the abstract store of the successor with OUT
             4. If the abstract store of the successor has changed, add the successor to the worklist
         */
         
         while (!worklist.empty()) {
             std::string current_bb = worklist.front();
             worklist.pop_front();
-            // Perform the transfer function on the current basic block
-            
-            execute(&program,
-                    pointsTo,
-                    modRefInfo_,
-                    func->bbs[current_bb],
+
+            execute(blocks.at(current_bb),
                     bb2store,
                     worklist,
-                    addr_taken,
                     bbs_to_output,
-                    soln
+                    defs
                     );
-
-            for (const auto &i: worklist) {
-                bbs_to_output.insert(i);
-            }
         }
 
         /*
-         * Once we've completed the worklist algorithm, let's execute our
-         * transfer function once more on each basic block to get their exit
-         * abstract stores.
+         * Once we've completed the worklist algorithm, let's walk each basic block once more from its entry store
+         * to get the definitions reaching the uses of every program point.
          */
 
         for (const auto &it : bbs_to_output) {
-            execute(&program,
-                    pointsTo,
-                    modRefInfo_,
-                    func->bbs[it],
-                    bb2store,
-                    worklist,
-                    addr_taken,
-                    bbs_to_output,
-                    soln,
-                    true
-                    );
+            execute_final(blocks.at(it), bb2store.at(it), soln, defs);
         }
 
         /*
@@ -280,9 +267,17 @@ public:
 
     Program program;
     /*
-     * Our bb2store is a map from a basic block label to a map of var name and a set of its definitions.
+     * Canonical types of the program, shared by every function analyzed
+     */
+    const TypeGraph& types;
+    /*
+     * Our bb2store is a map from a basic block label to the bit-vector of definitions reaching its entry.
+     */
+    std::map<std::string, BitVector> bb2store;
+    /*
+     * Variables and definitions of the function, numbered for the bit-vectors
      */
-    std::map<std::string, std::map<std::string, std::set<std::string>>> bb2store;
+    DefTable defs;
     /*
      * Our worklist is a queue containing BasicBlock labels.
      */
@@ -293,7 +288,7 @@ public:
     */
     std::map<std::string, std::set<std::string>> soln;
 
-    std::unordered_map<std::string, std::set<std::string>> pointsTo;
+    const PointsToIndex& pointsTo;
     std::map<std::string, ModRefInfo> modRefInfo_;
 
 private:
@@ -4,70 +4,65 @@
 #include<set>
 #include<iostream>
 #include "../headers/datatypes.h"
+#include "../headers/gen_kill.hpp"
+#include "../headers/type_graph.hpp"
 #include <deque>
+#include <string>
 #include <unordered_set>
 #include <unordered_map>
-#include "rtype.hpp"
+#include <utility>
+#include <vector>
 
 /*
- * Join is a union of the two abstract stores where each abstract store is a map of variable name to a set of pp where they are defined.
-*/
-bool joinAbsStore(std::map<std::string, std::set<std::string>>&curr_abs_store, std::map<std::string, std::set<std::string>>parent_bb_abs_store) {
-    
-    bool changed = false;
-    std::map<std::string, std::set<std::string>> result_set;
-    
-    // For elements in curr_abs_store, do a set union with the parent_bb_abs_store
-    // This also handles the case when the key is not present in parent_bb_abs_store but present in curr_abs_store
-    for(auto it = curr_abs_store.begin(); it != curr_abs_store.end(); it++) {
-        std::set<std::string> result_set;
-        std::set_union(it->second.begin(), it->second.end(), parent_bb_abs_store[it->first].begin(), parent_bb_abs_store[it->first].end(), std::inserter(result_set, result_set.begin()));
-        // We do not want to unset changed to false if alerady set to true
-        if (!changed)
-            changed = (result_set.size() != it->second.size());
-        it->second = result_set;
+ * WDEF of a call: { globals } U { v in addr_taken | type(v) in reachable_types(globals) } U { v in addr_taken | type(v) in reachable_types(args) }
+ */
+std::set<Variable*> GetCallWeakDefs(const Program *program, const TypeGraph &types, std::vector<Operand*> &args, std::unordered_set<Variable*> &addr_taken) {
+    std::set<Variable*> WDEF;
+
+    // Add all globals to WDEF
+    for (auto it = program->globals.begin(); it != program->globals.end(); it++) {
+        WDEF.insert((*it)->globalVar);
     }
 
-    // For elements in parent_bb_abs_store, if they are not in curr_abs_store, add them to curr_abs_store
-    for(auto it = parent_bb_abs_store.begin(); it != parent_bb_abs_store.end(); it++) {
-        if(curr_abs_store.count(it->first) == 0) {
-            curr_abs_store[it->first] = it->second;
-            changed = true;
-        }
+    // Reachable types of the globals and of the args
+    BitVector reachable_types = types.GlobalsReachable();
+    for (auto arg : args) {
+        if (arg->IsConstInt())
+            continue;
+        reachable_types.Union(types.Reachable(arg->var->type));
     }
-    return changed;
-}
 
-bool joinSets(std::set<std::string> &s1, std::set<std::string> &s2) {
-    bool changed = false;
-    std::set<std::string> result_set;
-    
-    std::set_union(s1.begin(), s1.end(), s2.begin(), s2.end(), std::inserter(result_set, result_set.begin()));
-    
-    changed = (result_set.size() != s1.size());
-    s1 = result_set;
-    return changed;
+    for (auto v : addr_taken) {
+        int type_id = types.Id(v->type);
+        if (type_id >= 0 && reachable_types.Test(type_id))
+            WDEF.insert(v);
+    }
+    return WDEF;
 }
 
-void execute(
-    Program *program,
-    BasicBlock *bb,
-    std::map<std::string, std::map<std::string, std::set<std::string>>> &bb2store,
-    std::deque<std::string> &worklist,
-    std::unordered_set<Variable*> &addr_taken,
-    std::set<std::string> &bbs_to_output,
-    std::map<std::string, std::set<std::string>> &soln,
-    bool execute_final = false
-)
-{
-    std::map<std::string, std::set<std::string>> sigma_prime = bb2store[bb->label];
+/*
+ * DEF/USE sets of every program point of bb and its successors
+ */
+BlockDefUse GetBlockDefUse(const Program *program, const TypeGraph &types, BasicBlock *bb, std::unordered_set<Variable*> &addr_taken, DefTable &defs) {
+    BlockDefUse block;
+    block.label = bb->label;
+
+    auto add = [&](const std::string &pp, const std::set<Variable*> &USE, const std::set<Variable*> &WDEF, Variable *SDEF) {
+        DefUse du;
+        du.pp = pp;
+        for (Variable *v : USE)
+            du.uses.push_back(defs.Var(v->name));
+        for (Variable *v : WDEF) {
+            int var = defs.Var(v->name);
+            du.weak_defs.push_back({var, defs.Def(pp, var)});
+        }
+        if (SDEF) {
+            int var = defs.Var(SDEF->name);
+            du.strong_defs.push_back({var, defs.Def(pp, var)});
+        }
+        block.pps.push_back(du);
+    };
 
-    /*
-     * We define DEF for definitions of the variable and USE for the uses of the variable.
-     * DEF = set of variables
-     * USE = set of variables
-    */
-    
     int index = 0; // To help build program point name
 
     /*
@@ -76,17 +71,11 @@ void execute(
     for (const Instruction *inst : bb->instructions) {
 
         std::string pp = bb->label + "." + std::to_string(index);
+        std::set<Variable*> USE;
 
         // arith, cmp, alloc, copy, gep, gfp work the same way
         if ((*inst).instrType == InstructionType::ArithInstrType) {
-
-            /*
-             * Cast it.
-             */
-             ArithInstruction *arith_inst = (ArithInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
-
+            ArithInstruction *arith_inst = (ArithInstruction *) inst;
             /*
              * x = $arith add y z
              * DEF = {x}
@@ -94,29 +83,15 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(arith_inst->lhs);
             if (!arith_inst->op1->IsConstInt())
                 USE.insert(arith_inst->op1->var);
             if (!arith_inst->op2->IsConstInt())
                 USE.insert(arith_inst->op2->var);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[arith_inst->lhs->name] = {pp};
+            add(pp, USE, {}, arith_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::CmpInstrType)
         {
-            /*
-             * Cast it.
-             */
-             CmpInstruction *cmp_inst = (CmpInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            CmpInstruction *cmp_inst = (CmpInstruction *) inst;
             /*
              * x = $cmp gt y z
              * DEF = {x}
@@ -124,29 +99,15 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(cmp_inst->lhs);
             if (!cmp_inst->op1->IsConstInt())
                 USE.insert(cmp_inst->op1->var);
             if (!cmp_inst->op2->IsConstInt())
                 USE.insert(cmp_inst->op2->var);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[cmp_inst->lhs->name] = {pp};
+            add(pp, USE, {}, cmp_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::CopyInstrType)
         {
-            /*
-             * Cast it.
-             */
-             CopyInstruction *copy_inst = (CopyInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            CopyInstruction *copy_inst = (CopyInstruction *) inst;
             /*
              * x = $copy y
              * DEF = {x}
@@ -154,27 +115,13 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(copy_inst->lhs);
             if (!copy_inst->op->IsConstInt())
                 USE.insert(copy_inst->op->var);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[copy_inst->lhs->name] = {pp};
+            add(pp, USE, {}, copy_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::AllocInstrType)
         {
-            /*
-             * Cast it.
-             */
-             AllocInstruction *alloc_inst = (AllocInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            AllocInstruction *alloc_inst = (AllocInstruction *) inst;
             /*
              * x = $alloc y [id]
              * DEF = {x}
@@ -182,28 +129,13 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(alloc_inst->lhs);
             if (!alloc_inst->num->IsConstInt())
                 USE.insert(alloc_inst->num->var);
-
-            if (execute_final) {
-
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[alloc_inst->lhs->name] = {pp};
+            add(pp, USE, {}, alloc_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::GepInstrType)
         {
-            /*
-             * Cast it.
-             */
-             GepInstruction *gep_inst = (GepInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            GepInstruction *gep_inst = (GepInstruction *) inst;
             /*
              * x = $gep id op
              * DEF = {x}
@@ -211,26 +143,15 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(gep_inst->lhs);
             if (!gep_inst->idx->IsConstInt())
                 USE.insert(gep_inst->idx->var);
             // TODO - Confirm this with Ben
             USE.insert(gep_inst->src);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[gep_inst->lhs->name] = {pp};
+            add(pp, USE, {}, gep_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::GfpInstrType)
         {
-             GfpInstruction *gfp_inst = (GfpInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            GfpInstruction *gfp_inst = (GfpInstruction *) inst;
             /*
              * x = $gfp id id
              * DEF = {x}
@@ -238,27 +159,13 @@ void execute(
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(gfp_inst->lhs);
             USE.insert(gfp_inst->src);
             //USE.insert(gfp_inst->field);
-            
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[gfp_inst->lhs->name] = {pp};
+            add(pp, USE, {}, gfp_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::AddrofInstrType)
         {
-            /*
-             * Cast it.
-             */
-             AddrofInstruction *addrof_inst = (AddrofInstruction *) inst;
-             std::set<Variable*> DEF;
-             std::set<Variable*> USE;
+            AddrofInstruction *addrof_inst = (AddrofInstruction *) inst;
             /*
              * x = $addrof y
              * DEF = {x}
@@ -266,28 +173,17 @@ void execute(
              * No update to soln required
              * sigma_prime[x] = { pp }
             */
-
-            DEF.insert(addrof_inst->lhs);
-            USE = {};
-
-            sigma_prime[addrof_inst->lhs->name] = { pp };
+            add(pp, USE, {}, addrof_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::LoadInstrType)
         {
-            /*
-             * Cast it.
-             */
             LoadInstruction *load_inst = (LoadInstruction *) inst;
-            std::set<Variable*> DEF;
-            std::set<Variable*> USE;
-
             /*
              * DEF = {x}
              * USE = {y} U { v in addr_taken | type(v) = type(x) }
              * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
              * sigma_prime[x] = { pp }
             */
-            DEF.insert(load_inst->lhs);
             USE.insert(load_inst->src);
 
             for (auto v : addr_taken) {
@@ -295,21 +191,12 @@ void execute(
                     USE.insert(v);
                 }
             }
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            sigma_prime[load_inst->lhs->name] = {pp};
+            add(pp, USE, {}, load_inst->lhs);
         }
         else if ((*inst).instrType == InstructionType::StoreInstrType)
         {
             StoreInstruction *store_inst = (StoreInstruction *) inst;
             std::set<Variable*> DEF;
-            std::set<Variable*> USE;
 
             /*
              * $store x op
@@ -333,22 +220,11 @@ void execute(
             USE.insert(store_inst->dst);
             if (!store_inst->op->IsConstInt())
                 USE.insert(store_inst->op->var);
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            for (Variable *v : DEF) {
-                sigma_prime[v->name].insert(pp);
-            }
+            add(pp, USE, DEF, nullptr);
         }
         else if ((*inst).instrType == InstructionType::CallExtInstrType)
         {
             CallExtInstruction *callext_inst = (CallExtInstruction *) inst;
-            std::set<Variable*> USE;
             /*
              * SDEF = {x} - Strong defs - definitely updating the variable
              * WDEF = { globals } U { v in addr_taken | type(v) in reachable_types(globals) } U { v in addr_taken | type(v) in reachable_types(args) } - Weak defs - may be updating the variable
@@ -357,65 +233,13 @@ void execute(
              * for all v in WDEF: sigma_prime[v] = sigma_prime[v] U { pp }
              * sigma_prime[x] = { pp }
             */
-            std::set<Variable*> SDEF;
-            std::set<Variable*> WDEF;
-
-            if (callext_inst->lhs)
-                SDEF.insert(callext_inst->lhs);
-            
-            // Add all globals to WDEF
-            for (auto it = program->globals.begin(); it != program->globals.end(); it++) {
-                WDEF.insert((*it)->globalVar);
-            }
-
-            // Get reachable types for all globals
-            std::unordered_set<ReachableType*> global_reachable_types;
-            for (auto gl : program->globals) {
-                ReachableType *var_type = new ReachableType(gl->globalVar->type);
-                ReachableType::GetReachableType(program, var_type, global_reachable_types);
-            }
-
-            // Get reachable types for all args
-            std::unordered_set<ReachableType*> args_reachable_types;
-            for (auto arg : callext_inst->args) {
-                if (arg->IsConstInt())
-                    continue;
-                ReachableType *var_type = new ReachableType(arg->var->type);
-                ReachableType::GetReachableType(program, var_type, args_reachable_types);
-            }
-
-            for (auto v : addr_taken) {
-                if (ReachableType::isPresentInSet(global_reachable_types, new ReachableType(v->type)))
-                    WDEF.insert(v);
-            }
-
-            for (auto v : addr_taken) {
-                if (ReachableType::isPresentInSet(args_reachable_types, new ReachableType(v->type)))
-                    WDEF.insert(v);
-            }
-
-            std::copy(WDEF.begin(), WDEF.end(), std::inserter(USE, USE.end()));
-            
+            std::set<Variable*> WDEF = GetCallWeakDefs(program, types, callext_inst->args, addr_taken);
+            USE = WDEF;
             for(auto arg : callext_inst->args) {
                 if (!arg->IsConstInt())
                     USE.insert(arg->var);
             }
-
-            if (execute_final) {
-                for (Variable *v : USE) {
-                    // soln[pp] = soln[pp] U sigma_prime[v]
-                    joinSets(soln[pp], sigma_prime[v->name]);
-                }
-            }
-
-            for (Variable *v : WDEF) {
-                // sigma_prime[v] = sigma_prime[v] U { pp }
-                sigma_prime[v->name].insert(pp);
-            }
-
-            if (callext_inst->lhs)
-                sigma_prime[callext_inst->lhs->name] = {pp};
-
+            add(pp, USE, WDEF, callext_inst->lhs);
         }
         index += 1;
     }
@@ -423,253 +247,83 @@ void execute(
     Instruction *terminal_instruction = bb->terminal;
 
     std::string pp = bb->label + "." + "term";
-    
+    std::set<Variable*> USE;
+
     if ((*terminal_instruction).instrType == InstructionType::JumpInstrType)
     {
         JumpInstruction *jump_inst = (JumpInstruction *) terminal_instruction;
-        std::set<Variable*> USE;
-        std::set<Variable*> DEF;
-
         /*
          * DEF = {}
          * USE = {}
-         * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v] => since USE is empty, no update to soln
         */
-
-        // For target basic block, join bb2store[target] with sigma_prime and add target to worklist if changed
-        if (!execute_final) {
-            bool store_changed = joinAbsStore(bb2store[jump_inst->label], sigma_prime);
-            if (store_changed || bbs_to_output.count(jump_inst->label) == 0) {
-                worklist.push_back(jump_inst->label);
-                bbs_to_output.insert(jump_inst->label);
-            }
-        }
+        add(pp, USE, {}, nullptr);
+        block.succs.push_back(jump_inst->label);
     }
     else if ((*terminal_instruction).instrType == InstructionType::BranchInstrType)
     {
         BranchInstruction *branch_inst = (BranchInstruction *) terminal_instruction;
-
         /*
          * DEF = {}
          * USE = { op | op is a variable }
          * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
         */
-        std::set<Variable*> USE;
-        std::set<Variable*> DEF;
-
         if (!branch_inst->condition->IsConstInt())
             USE.insert(branch_inst->condition->var);
-
-        if (execute_final) {
-            for (Variable *v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v->name]);
-            }
-        }
-
-        // For target basic block, join bb2store[target] with sigma_prime and add target to worklist if changed
-        if (!execute_final) {
-            
-            bool store_changed_tt = joinAbsStore(bb2store[branch_inst->tt], sigma_prime);
-            bool store_changed_ff = joinAbsStore(bb2store[branch_inst->ff], sigma_prime);
-
-            if (store_changed_tt || bbs_to_output.count(branch_inst->tt) == 0) {
-                worklist.push_back(branch_inst->tt);
-                bbs_to_output.insert(branch_inst->tt);
-            }
-
-            if (store_changed_ff || bbs_to_output.count(branch_inst->ff) == 0) {
-                worklist.push_back(branch_inst->ff);
-                bbs_to_output.insert(branch_inst->ff);
-            }
-        }
+        add(pp, USE, {}, nullptr);
+        block.succs.push_back(branch_inst->tt);
+        block.succs.push_back(branch_inst->ff);
     }
     else if ((*terminal_instruction).instrType == InstructionType::RetInstrType)
     {
         RetInstruction *ret_inst = (RetInstruction *) terminal_instruction;
-
         /*
          * DEF = {}
          * USE = { op | op is a variable }
          * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
         */
-        std::set<Variable*> USE;
-        std::set<Variable*> DEF;
-
         if (ret_inst->op && !(ret_inst->op->IsConstInt()))
             USE.insert(ret_inst->op->var);
-        
-        if (execute_final) {
-            for (Variable *v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v->name]);
-            }
-        }
+        add(pp, USE, {}, nullptr);
     }
     else if ((*terminal_instruction).instrType == InstructionType::CallDirInstrType)
     {
         CallDirInstruction *calldir_inst = (CallDirInstruction *) terminal_instruction;
-
-        std::set<Variable*> USE;
         /*
             * SDEF = {x} - Strong defs - definitely updating the variable
             * WDEF = { globals } U { v in addr_taken | type(v) in reachable_types(globals) } U { v in addr_taken | type(v) in reachable_types(args) } - Weak defs - may be updating the variable
-            * USE = { fp } U { arg | arg is a variable } U WDEF // add fp only in case of call_idr
+            * USE = { arg | arg is a variable } U WDEF
             * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
             * for all v in WDEF: sigma_prime[v] = sigma_prime[v] U { pp }
             * sigma_prime[x] = { pp }
         */
-        std::set<Variable*> SDEF;
-        std::set<Variable*> WDEF;
-
-        if (calldir_inst->lhs)
-            SDEF.insert(calldir_inst->lhs);
-        
-        // Add all globals to WDEF
-        for (auto it = program->globals.begin(); it != program->globals.end(); it++) {
-            WDEF.insert((*it)->globalVar);
-        }
-
-        // Get reachable types for all globals
-            std::unordered_set<ReachableType*> global_reachable_types;
-            for (auto gl : program->globals) {
-                ReachableType *var_type = new ReachableType(gl->globalVar->type);
-                ReachableType::GetReachableType(program, var_type, global_reachable_types);
-            }
-
-            // Get reachable types for all args
-            std::unordered_set<ReachableType*> args_reachable_types;
-            for (auto arg : calldir_inst->args) {
-                if (arg->IsConstInt())
-                    continue;
-                ReachableType *var_type = new ReachableType(arg->var->type);
-                ReachableType::GetReachableType(program, var_type, args_reachable_types);
-            }
-
-            for (auto v : addr_taken) {
-                if (ReachableType::isPresentInSet(global_reachable_types, new ReachableType(v->type)))
-                    WDEF.insert(v);
-            }
-
-            for (auto v : addr_taken) {
-                if (ReachableType::isPresentInSet(args_reachable_types, new ReachableType(v->type)))
-                    WDEF.insert(v);
-            }
-
-        // Add WDEF to USE
-        std::copy(WDEF.begin(), WDEF.end(), std::inserter(USE, USE.end()));
-        
+        std::set<Variable*> WDEF = GetCallWeakDefs(program, types, calldir_inst->args, addr_taken);
+        USE = WDEF;
         for(auto arg : calldir_inst->args) {
             if (!arg->IsConstInt())
                 USE.insert(arg->var);
         }
-
-        if (execute_final) {
-            for (Variable *v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v->name]);
-            }
-        }
-
-        for (Variable *v : WDEF) {
-            // sigma_prime[v] = sigma_prime[v] U { pp }
-            sigma_prime[v->name].insert(pp);
-        }
-
-        if (calldir_inst->lhs)
-            sigma_prime[calldir_inst->lhs->name] = {pp};
-
-        if (!execute_final) {
-            if (joinAbsStore(bb2store[calldir_inst->next_bb], sigma_prime) || bbs_to_output.count(calldir_inst->next_bb) == 0) {
-                worklist.push_back(calldir_inst->next_bb);
-                bbs_to_output.insert(calldir_inst->next_bb);
-            }
-        }
-
+        add(pp, USE, WDEF, calldir_inst->lhs);
+        block.succs.push_back(calldir_inst->next_bb);
     }
     else if ((*terminal_instruction).instrType == InstructionType::CallIdrInstrType)
     {
         CallIdrInstruction *callidir_inst = (CallIdrInstruction *) terminal_instruction;
-
-        std::set<Variable*> USE;
         /*
-            * SDEF = {x} - Strong defs - definitely updating the variable
-            * WDEF = { globals } U { v in addr_taken | type(v) in reachable_types(globals) } U { v in addr_taken | type(v) in reachable_types(args) } - Weak defs - may be updating the variable
-            * USE = { fp } U { arg | arg is a variable } U WDEF // add fp only in case of call_idr
-            * for all v in USE: soln[pp] = soln[pp] U sigma_prime[v]
-            * for all v in WDEF: sigma_prime[v] = sigma_prime[v] U { pp }
-            * sigma_prime[x] = { pp }
+            * Same as call_dir, with USE = { fp } U { arg | arg is a variable } U WDEF
         */
-        std::set<Variable*> SDEF;
-        std::set<Variable*> WDEF;
-
-        if (callidir_inst->lhs)
-            SDEF.insert(callidir_inst->lhs);
-        
-        // Add all globals to WDEF
-        for (auto it = program->globals.begin(); it != program->globals.end(); it++) {
-            WDEF.insert((*it)->globalVar);
-        }
-        // Get reachable types for all globals
-        std::unordered_set<ReachableType*> global_reachable_types;
-        for (auto gl : program->globals) {
-            ReachableType *var_type = new ReachableType(gl->globalVar->type);
-            ReachableType::GetReachableType(program, var_type, global_reachable_types);
-        }
-
-        // Get reachable types for all args
-        std::unordered_set<ReachableType*> args_reachable_types;
-        for (auto arg : callidir_inst->args) {
-            if (arg->IsConstInt())
-                continue;
-            ReachableType *var_type = new ReachableType(arg->var->type);
-            ReachableType::GetReachableType(program, var_type, args_reachable_types);
-        }
-
-        for (auto v : addr_taken) {
-            if (ReachableType::isPresentInSet(global_reachable_types, new ReachableType(v->type)))
-                WDEF.insert(v);
-        }
-
-        for (auto v : addr_taken) {
-            if (ReachableType::isPresentInSet(args_reachable_types, new ReachableType(v->type)))
-                WDEF.insert(v);
-        }
-
-        std::copy(WDEF.begin(), WDEF.end(), std::inserter(USE, USE.end()));
-
+        std::set<Variable*> WDEF = GetCallWeakDefs(program, types, callidir_inst->args, addr_taken);
+        USE = WDEF;
         for(auto arg : callidir_inst->args) {
             if (!arg->IsConstInt())
                 USE.insert(arg->var);
         }
         USE.insert(callidir_inst->fp);
-
-        if (execute_final) {
-            for (Variable *v : USE) {
-                // soln[pp] = soln[pp] U sigma_prime[v]
-                joinSets(soln[pp], sigma_prime[v->name]);
-            }
-        }
-
-        for (Variable *v : WDEF) {
-            // sigma_prime[v] = sigma_prime[v] U { pp }
-            sigma_prime[v->name].insert(pp);
-        }
-
-        if (callidir_inst->lhs)
-            sigma_prime[callidir_inst->lhs->name] = {pp};
-
-        if (!execute_final) {
-            if (joinAbsStore(bb2store[callidir_inst->next_bb], sigma_prime) || bbs_to_output.count(callidir_inst->next_bb) == 0) {
-                worklist.push_back(callidir_inst->next_bb);
-                bbs_to_output.insert(callidir_inst->next_bb);
-            }
-        }
-
+        add(pp, USE, WDEF, callidir_inst->lhs);
+        block.succs.push_back(callidir_inst->next_bb);
     }
     else
     {
         std::cout << "Unknown terminal instruction type" << std::endl;
     }
-    return;
-}
\ No newline at end of file
+    return block;
+}
@@ -2,7 +2,7 @@
 #include <unordered_set>
 #include <fstream>
 #include "../../../headers/datatypes.h"
-#include "../../rtype.hpp"
+#include "../../../headers/type_graph.hpp"
 
 int main(int argc, char* argv[]) 
 {
@@ -20,16 +20,12 @@ int main(int argc, char* argv[])
     Function *func = program.funcs[func_name];
 
     std::string var_name = argv[3];
-    ReachableType *var_type = new ReachableType(func->locals[var_name]->type);
-
-    std::unordered_set<ReachableType*> rset;
-    ReachableType::GetReachableType(&program, var_type, rset);
+    TypeGraph types(&program);
 
     std::cout << "Reachable types for " << var_name << " in " << func_name << std::endl;
-    for (auto it = rset.begin(); it != rset.end(); it++)
-    {
-        (*it)->pretty_print();
-    }
+    types.Reachable(func->locals[var_name]->type).ForEach([&](int type_id) {
+        types.Fake(type_id)->type->pretty_print();
+    });
 
     return 0;
 }
\ No newline at end of file
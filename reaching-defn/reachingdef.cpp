@@ -1,4 +1,7 @@
+#include <atomic>
 #include <fstream>
+#include <sstream>
+#include <thread>
 #include <vector>
 #include <unordered_set>
 #include <set>
@@ -10,7 +13,7 @@
 
 #include "../headers/datatypes.h"
 #include "execute_rdef.hpp"
-#include "rtype.hpp"
+#include "../headers/type_graph.hpp"
 
 using json = nlohmann::json;
 
@@ -27,7 +30,7 @@ public:
      */
     std::set<std::string> bbs_to_output;
 
-    ReachingDef(Program program) : program(program) {};
+    ReachingDef(const Program& program, const TypeGraph& types) : program(program), types(types) {};
 
     /*
     Method to get all pointer typed globals, parameters, locals of the function
@@ -40,12 +43,12 @@ public:
                 PTRS.insert(global_var_ptr);
             }  
         }
-        for (auto param : program.funcs[funcname]->params) {
+        for (auto param : program.funcs.at(funcname)->params) {
             if (param->type->indirection > 0) {
                 PTRS.insert(param);
             }
         }
-        for (auto local : program.funcs[funcname]->locals) {
+        for (auto local : program.funcs.at(funcname)->locals) {
             if (local.second->type->indirection > 0) {
                 PTRS.insert(local.second);
             }
@@ -54,14 +57,14 @@ public:
     }
 
     /*
-     * Wrapper function to get reachable types for all ptr typed variables in the function
+     * Union of the reachable types of all ptr typed variables in the function
     */
-    void get_reachable_types(std::unordered_set<Variable*> &PTRS, std::unordered_set<ReachableType*> &reachable_types, Program *program) {
+    BitVector get_reachable_types(std::unordered_set<Variable*> &PTRS) {
+        BitVector reachable_types(types.size());
         for (auto ptr : PTRS) {
-            ReachableType *var_type = new ReachableType(ptr->type);
-            ReachableType::GetReachableType(program, var_type, reachable_types);
+            reachable_types.Union(types.Reachable(ptr->type));
         }
-        return;
+        return reachable_types;
     }
 
     /*
@@ -80,10 +83,10 @@ public:
      * Get all address taken local variable + function parameters + global variables
     */
     void get_addr_taken(std::unordered_set<Variable*> &addr_taken) {  
-        for (auto basic_block : program.funcs[funcname]->bbs) {
+        for (auto basic_block : program.funcs.at(funcname)->bbs) {
             for (auto instruction = basic_block.second->instructions.begin(); instruction != basic_block.second->instructions.end(); ++instruction) {
                 if ((*instruction)->instrType == InstructionType::AddrofInstrType) {
-                        if (program.funcs[funcname]->locals.count(dynamic_cast<AddrofInstruction*>(*instruction)->rhs->name) != 0)
+                        if (program.funcs.at(funcname)->locals.count(dynamic_cast<AddrofInstruction*>(*instruction)->rhs->name) != 0)
                         {
                             if (!isPresentInAddrTaken(addr_taken, dynamic_cast<AddrofInstruction*>(*instruction)->rhs))
                                 addr_taken.insert(dynamic_cast<AddrofInstruction*>(*instruction)->rhs);
@@ -100,7 +103,7 @@ public:
                                 }
                             }
 
-                            for (auto param : program.funcs[funcname]->params) {
+                            for (auto param : program.funcs.at(funcname)->params) {
                                 if (param && param->name == dynamic_cast<AddrofInstruction*>(*instruction)->rhs->name) {
                                     if (!isPresentInAddrTaken(addr_taken, dynamic_cast<AddrofInstruction*>(*instruction)->rhs))
                                         addr_taken.insert(dynamic_cast<AddrofInstruction*>(*instruction)->rhs);
@@ -147,22 +150,28 @@ public:
     };
 
     /*
-        Uber level method to run the analysis on a function
+        Uber level method to run the analysis on a function and print its solution to out
+        The state of the previous run is reset first, so one instance can analyze several functions in turn.
     */
-    void AnalyzeFunc(const std::string &func_name) {
+    void AnalyzeFunc(const std::string &func_name, std::ostream &out = std::cout) {
 
-        Function *func = program.funcs[func_name];
+        auto func_it = program.funcs.find(func_name);
+        Function *func = func_it != program.funcs.end() ? func_it->second : nullptr;
         if (!func) {
-            std::cout << "Function not found" << std::endl;
+            out << "Function not found" << std::endl;
             return;
         }
 
         funcname = func_name;
+        bbs_to_output.clear();
+        bb2store.clear();
+        defs = DefTable();
+        worklist.clear();
+        soln.clear();
 
 
         // data structures required for prep stage
         std::unordered_set<Variable*> addr_taken; // contains all variables that are address taken i.e addrof is used on them
-        std::unordered_set<ReachableType*> reachable_types; // reachable data types from all pointers in the function
         
         // Prep steps:
         
@@ -173,22 +182,29 @@ public:
         std::unordered_set<Variable*> PTRS = get_ptrs(); // Get all pointer typed globals, parameters, locals of the function
 
         // 3. Get reachable types for all ptr typed variables in the function
-        get_reachable_types(PTRS, reachable_types, &program);
+        BitVector reachable_types = get_reachable_types(PTRS); // reachable data types from all pointers in the function
         
-        // 4. Put all fake variables in the address taken set
-        int i=0;
-        std::unordered_set<ReachableType*> types_considered_for_fakes;
-        for (auto rtype : reachable_types) {
-            ReachableType *faketype = new ReachableType(rtype->type, rtype->ptr_type, rtype->indirection);
-            addr_taken.insert(new Variable("fake_var_" + std::to_string(i), (Type*) faketype));
-            i += 1;
-        }
+        // 4. Put the fake variable of every reachable type in the address taken set
+        reachable_types.ForEach([&](int type_id) {
+            addr_taken.insert(types.Fake(type_id));
+        });
 
         /*
             Setup steps
-            1. Initialize the abstract store for 'entry' basic block
-            2. Add 'entry' basic block to worklist
+            1. Compute DEF/USE of every program point, numbering variables and definitions
+            2. Summarize every block by its GEN and KILL sets
+            3. Initialize the abstract store for 'entry' basic block and add it to the worklist
         */
+        std::map<std::string, BlockDefUse> blocks;
+        for (auto [label, bb] : func->bbs) {
+            blocks[label] = GetBlockDefUse(&program, types, bb, addr_taken, defs);
+        }
+        defs.Finalize();
+        for (auto &[label, block] : blocks) {
+            SummarizeBlock(block, defs);
+        }
+
+        bb2store.try_emplace("entry", defs.NumDefs());
         worklist.push_back("entry");
         bbs_to_output.insert("entry");
 
@@ -196,8 +212,8 @@ public:
         /*
             Worklist algorithm
             1. Pop a basic block from the worklist
-            2. Perform the transfer function on the basic block
-            3. For each successor of the basic block, join the abstract store of the successor with the abstract store of the current basic block
+            2. Apply the block's transfer function OUT = GEN U (IN - KILL)
+            3. For each successor of the basic block, join the abstract store of the successor with OUT
             4. If the abstract store of the successor has changed, add the successor to the worklist
         */
         
@@ -205,38 +221,21 @@ public:
             std::string current_bb = worklist.front();
             worklist.pop_front();
 
-            // Perform the transfer function on the current basic block
-            
-            execute(&program,
-                    func->bbs[current_bb],
+            execute(blocks.at(current_bb),
                     bb2store,
                     worklist,
-                    addr_taken,
                     bbs_to_output,
-                    soln
+                    defs
                     );
-
-            for (const auto &i: worklist) {
-                bbs_to_output.insert(i);
-            }
         }
 
         /*
-         * Once we've completed the worklist algorithm, let's execute our
-         * transfer function once more on each basic block to get their exit
-         * abstract stores.
+         * Once we've completed the worklist algorithm, let's walk each basic block once more from its entry store
+         * to get the definitions reaching the uses of every program point.
          */
 
         for (const auto &it : bbs_to_output) {
-            execute(&program,
-                    func->bbs[it],
-                    bb2store,
-                    worklist,
-                    addr_taken,
-                    bbs_to_output,
-                    soln,
-                    true
-                    );
+            execute_final(blocks.at(it), bb2store.at(it), soln, defs);
         }
 
         /*
@@ -254,7 +253,7 @@ public:
             if (soln[*it].size() == 0) {
                 continue;
             }
-            std::cout << *it << " -> {";
+            out << *it << " -> {";
             int indx = 0;
             int size = soln[*it].size();
 
@@ -266,19 +265,27 @@ public:
 
             for (auto def = defs.begin(); def != defs.end(); def++, indx++) {
                 if (indx == size - 1) {
-                    std::cout << *def << "}" << std::endl;
+                    out << *def << "}" << std::endl;
                 } else {
-                    std::cout << *def << ", ";
+                    out << *def << ", ";
                 }
             }
         }
     }
 
-    Program program;
+    const Program& program;
+    /*
+     * Canonical types of the program, shared by every function analyzed
+     */
+    const TypeGraph& types;
+    /*
+     * Our bb2store is a map from a basic block label to the bit-vector of definitions reaching its entry.
+     */
+    std::map<std::string, BitVector> bb2store;
     /*
-     * Our bb2store is a map from a basic block label to a map of var name and a set of its definitions.
+     * Variables and definitions of the function, numbered for the bit-vectors
      */
-    std::map<std::string, std::map<std::string, std::set<std::string>>> bb2store;
+    DefTable defs;
     /*
      * Our worklist is a queue containing BasicBlock labels.
      */
@@ -293,21 +300,76 @@ private:
     std::string funcname;
 };
 
+/*
+ * Analyze every function of the program with num_threads workers, each with its own engine over the shared
+ * program and type graph, and print the solutions in order of function name
+ */
+void AnalyzeAllFuncs(const Program &program, const TypeGraph &types, int num_threads) {
+    std::vector<std::string> func_names;
+    for (auto &[func_name, func] : program.funcs) {
+        func_names.push_back(func_name);
+    }
+    std::sort(func_names.begin(), func_names.end());
+
+    std::vector<std::ostringstream> outputs(func_names.size());
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        ReachingDef reaching_def = ReachingDef(program, types);
+        for (int i = next++; i < func_names.size(); i = next++) {
+            reaching_def.AnalyzeFunc(func_names[i], outputs[i]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_threads; i++) {
+        workers.emplace_back(worker);
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    for (int i = 0; i < func_names.size(); i++) {
+        std::cout << func_names[i] << ":" << std::endl << outputs[i].str() << std::endl;
+    }
+}
+
 int main(int argc, char* argv[]) 
 {
-    if (argc != 4) {
-        std::cerr << "Usage: reachingdef <lir file path> <lir json filepath> <funcname>" << std::endl;
+    const char* usage = "Usage: reachingdef <lir file path> <lir json filepath> <funcname | --all> [--threads <n>]";
+    if (argc < 4) {
+        std::cerr << usage << std::endl;
         return EXIT_FAILURE;
     }
 
+    // --all analyzes every function; --threads sets the number of workers doing so (0 = one per core)
+    int num_threads = 1;
+    for (int i = 4; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            num_threads = std::stoi(argv[++i]);
+            if (num_threads <= 0)
+                num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else {
+            std::cerr << usage << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     std::ifstream f(argv[2]);
     json lir_json = json::parse(f);
 
     std::string func_name = argv[3];
 
     Program program = Program(lir_json);
-    ReachingDef reaching_def = ReachingDef(program);
+    TypeGraph types(&program);
+    if (func_name == "--all") {
+        AnalyzeAllFuncs(program, types, num_threads);
+        return 0;
+    }
+
+    ReachingDef reaching_def = ReachingDef(program, types);
     reaching_def.AnalyzeFunc(func_name);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "./execute_taint.hpp"
+
+/*
+ * Demand-driven backward taint queries
+ * Answers "which sources can reach this sink call" without running the forward analysis. One linear pass over
+ * the program only indexes, for every store key, the sites that can define it. A query searches backward from
+ * the keys the sink reads - its arguments and everything reachable from them - and looks up the dependencies of
+ * a key at its def sites when it first reaches it, so only the part of the program the sink depends on is
+ * explored and there is no fixpoint over stores.
+ *
+ * The search is flow and context insensitive: its answer contains every source the forward analysis reports
+ * for the sink under any sensitivity, and may contain more.
+*/
+class BackwardTaintQuery {
+    public:
+
+    struct SinkCall {
+        std::string site; // func.bb.index
+        Function *func;
+        BasicBlock *bb;
+        int index;
+        CallExtInstruction *inst;
+    };
+
+    BackwardTaintQuery(Program *program, const PointsToIndex& pointsTo) : program_(program), pointsTo_(pointsTo) {
+        for (auto [func_name, func] : program->funcs) {
+            for (auto [label, bb] : func->bbs) {
+                for (int index = 0; index < bb->instructions.size(); index++)
+                    IndexInstruction(func, bb, index);
+                IndexTerminal(func, bb);
+            }
+        }
+        std::sort(sink_calls_.begin(), sink_calls_.end(), [](const SinkCall& a, const SinkCall& b) {
+            return std::make_tuple(a.func->name, a.bb->label, a.index) < std::make_tuple(b.func->name, b.bb->label, b.index);
+        });
+    }
+
+    /*
+     * Sink calls named by query: a callsite func.bb.index (index of the call in its block) or a sink, for all its calls
+     */
+    std::vector<SinkCall> Resolve(const std::string& query) const {
+        std::vector<SinkCall> calls;
+        for (const SinkCall& call : sink_calls_) {
+            if (call.site == query || call.inst->extFuncName == query)
+                calls.push_back(call);
+        }
+        return calls;
+    }
+
+    TaintSet Sources(const SinkCall& call) const {
+        std::deque<std::string> worklist;
+        std::unordered_set<std::string> visited;
+        auto visit = [&](const std::string& key) {
+            if (visited.insert(key).second)
+                worklist.push_back(key);
+        };
+
+        for (Operand *arg : call.inst->args) {
+            if (!arg->IsConstInt())
+                visit(GetKey(program_, call.func, arg->var));
+        }
+        for (int id : GetReachable(call.inst->args, pointsTo_, program_, call.func)) {
+            visit(pointsTo_.Name(id));
+        }
+
+        TaintSet sources;
+        while (!worklist.empty()) {
+            std::string key = worklist.front();
+            worklist.pop_front();
+            auto sites = defs_.find(key);
+            if (sites == defs_.end())
+                continue;
+            for (const DefSite& site : sites->second)
+                Deps(site, sources, visit);
+        }
+        return sources;
+    }
+
+    private:
+
+    // index of a block's call terminal in a DefSite
+    static constexpr int kTerminal = -1;
+
+    /*
+     * A site that can define a key. For an extern call slot is the argument whose reachable locations it
+     * writes, or ExternRule::kReturn for its result; for a call terminal it is the callee's parameter, or
+     * ExternRule::kReturn for the call's lhs.
+    */
+    struct DefSite {
+        Function *func;
+        BasicBlock *bb;
+        int index;
+        int slot = ExternRule::kReturn;
+        Function *callee = nullptr;
+    };
+
+    void Def(const std::string& key, const DefSite& site) {
+        defs_[key].push_back(site);
+    }
+
+    void Def(Variable *var, const DefSite& site) {
+        Def(GetKey(program_, site.func, var), site);
+    }
+
+    void IndexInstruction(Function *func, BasicBlock *bb, int index) {
+        Instruction *inst = bb->instructions[index];
+        DefSite site = {func, bb, index};
+        switch (inst->instrType) {
+            case InstructionType::ArithInstrType:
+                Def(((ArithInstruction *) inst)->lhs, site);
+                break;
+            case InstructionType::CmpInstrType:
+                Def(((CmpInstruction *) inst)->lhs, site);
+                break;
+            case InstructionType::CopyInstrType:
+                Def(((CopyInstruction *) inst)->lhs, site);
+                break;
+            case InstructionType::GepInstrType:
+                Def(((GepInstruction *) inst)->lhs, site);
+                break;
+            case InstructionType::GfpInstrType:
+                Def(((GfpInstruction *) inst)->lhs, site);
+                break;
+            case InstructionType::LoadInstrType:
+                Def(((LoadInstruction *) inst)->lhs, site);
+                break;
+            case InstructionType::StoreInstrType: {
+                StoreInstruction *store_inst = (StoreInstruction *) inst;
+                for (auto pointed_to : pointsTo_.PointsTo(GetKey(program_, func, store_inst->dst)))
+                    Def(pointed_to, site);
+                break;
+            }
+            case InstructionType::CallExtInstrType: {
+                CallExtInstruction *callext_inst = (CallExtInstruction *) inst;
+                const ExternRule *rule = GetExternRule(program_, callext_inst);
+                if (rule == nullptr)
+                    break;
+                std::vector<Operand*> &args = callext_inst->args;
+                if (rule->kind == ExternKind::Source) {
+                    if (callext_inst->lhs)
+                        Def(callext_inst->lhs, site);
+                    for (int id : GetReachable(args, pointsTo_, program_, func)) {
+                        Def(pointsTo_.Name(id), site);
+                    }
+                }
+                else if (rule->kind == ExternKind::Sink) {
+                    std::string site_name = func->name + "." + bb->label + "." + std::to_string(index);
+                    sink_calls_.push_back({site_name, func, bb, index, callext_inst});
+                }
+                else if (rule->kind == ExternKind::Other) {
+                    std::set<int> outs;
+                    for (auto [from, to] : rule->flows) {
+                        if (from < args.size())
+                            outs.insert(to);
+                    }
+                    for (int to : outs) {
+                        site.slot = to;
+                        if (to == ExternRule::kReturn) {
+                            if (callext_inst->lhs)
+                                Def(callext_inst->lhs, site);
+                        }
+                        else if (to < args.size() && !args[to]->IsConstInt()) {
+                            for (int id : GetReachable({args[to]}, pointsTo_, program_, func)) {
+                                Def(pointsTo_.Name(id), site);
+                            }
+                        }
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // A call defines the parameters of its callees and its lhs
+    void IndexTerminal(Function *func, BasicBlock *bb) {
+        if (bb->terminal->instrType == InstructionType::CallDirInstrType) {
+            CallDirInstruction *calldir_inst = (CallDirInstruction *) bb->terminal;
+            IndexCall(func, bb, calldir_inst->callee, calldir_inst->args, calldir_inst->lhs);
+        }
+        else if (bb->terminal->instrType == InstructionType::CallIdrInstrType) {
+            CallIdrInstruction *callidr_inst = (CallIdrInstruction *) bb->terminal;
+            for (auto callee : pointsTo_.PointsTo(GetKey(program_, func, callidr_inst->fp)))
+                IndexCall(func, bb, callee, callidr_inst->args, callidr_inst->lhs);
+        }
+    }
+
+    void IndexCall(Function *func, BasicBlock *bb, const std::string &callee, std::vector<Operand*> &args, Variable *lhs) {
+        if (program_->funcs.count(callee) == 0)
+            return;
+        Function *callee_func = program_->funcs[callee];
+        for (int i = 0; i < args.size() && i < callee_func->params.size(); i++)
+            Def(callee + "." + callee_func->params[i]->name, {func, bb, kTerminal, i, callee_func});
+        if (lhs != nullptr)
+            Def(lhs, {func, bb, kTerminal, ExternRule::kReturn, callee_func});
+    }
+
+    /*
+     * Visit the keys the definition at site is computed from, and add the sources it introduces
+    */
+    template <typename Visit>
+    void Deps(const DefSite& site, TaintSet& sources, Visit& visit) const {
+        Function *func = site.func;
+        auto dep = [&](Operand *op) {
+            if (!op->IsConstInt())
+                visit(GetKey(program_, func, op->var));
+        };
+        // key <- arg and everything reachable from it
+        auto dep_on_arg = [&](Operand *arg) {
+            if (arg->IsConstInt())
+                return;
+            visit(GetKey(program_, func, arg->var));
+            for (int id : GetReachable({arg}, pointsTo_, program_, func)) {
+                visit(pointsTo_.Name(id));
+            }
+        };
+
+        if (site.index == kTerminal) {
+            std::vector<Operand*> &args = site.bb->terminal->instrType == InstructionType::CallDirInstrType
+                ? ((CallDirInstruction *) site.bb->terminal)->args
+                : ((CallIdrInstruction *) site.bb->terminal)->args;
+            if (site.slot != ExternRule::kReturn) {
+                dep(args[site.slot]);
+                return;
+            }
+            for (auto [label, callee_bb] : site.callee->bbs) {
+                if (callee_bb->terminal->instrType != InstructionType::RetInstrType)
+                    continue;
+                Operand *ret_op = ((RetInstruction *) callee_bb->terminal)->op;
+                if (ret_op != nullptr && !ret_op->IsConstInt())
+                    visit(GetKey(program_, site.callee, ret_op->var));
+            }
+            return;
+        }
+
+        Instruction *inst = site.bb->instructions[site.index];
+        switch (inst->instrType) {
+            case InstructionType::ArithInstrType: {
+                ArithInstruction *arith_inst = (ArithInstruction *) inst;
+                dep(arith_inst->op1);
+                dep(arith_inst->op2);
+                break;
+            }
+            case InstructionType::CmpInstrType: {
+                CmpInstruction *cmp_inst = (CmpInstruction *) inst;
+                dep(cmp_inst->op1);
+                dep(cmp_inst->op2);
+                break;
+            }
+            case InstructionType::CopyInstrType:
+                dep(((CopyInstruction *) inst)->op);
+                break;
+            case InstructionType::GepInstrType: {
+                GepInstruction *gep_inst = (GepInstruction *) inst;
+                visit(GetKey(program_, func, gep_inst->src));
+                dep(gep_inst->idx);
+                break;
+            }
+            case InstructionType::GfpInstrType:
+                visit(GetKey(program_, func, ((GfpInstruction *) inst)->src));
+                break;
+            case InstructionType::LoadInstrType: {
+                std::string src = GetKey(program_, func, ((LoadInstruction *) inst)->src);
+                visit(src);
+                for (auto pointed_to : pointsTo_.PointsTo(src))
+                    visit(pointed_to);
+                break;
+            }
+            case InstructionType::StoreInstrType: {
+                StoreInstruction *store_inst = (StoreInstruction *) inst;
+                dep(store_inst->op);
+                visit(GetKey(program_, func, store_inst->dst));
+                break;
+            }
+            case InstructionType::CallExtInstrType: {
+                CallExtInstruction *callext_inst = (CallExtInstruction *) inst;
+                const ExternRule *rule = GetExternRule(program_, callext_inst);
+                if (rule->kind == ExternKind::Source) {
+                    sources.Union(TaintSet::Of(source_ids.at(callext_inst->extFuncName)));
+                    break;
+                }
+                for (auto [from, to] : rule->flows) {
+                    if (to == site.slot && from < callext_inst->args.size())
+                        dep_on_arg(callext_inst->args[from]);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    Program *program_;
+    const PointsToIndex& pointsTo_;
+    std::unordered_map<std::string, std::vector<DefSite>> defs_; // key -> sites that can define it
+    std::vector<SinkCall> sink_calls_;                           // sorted by (func, bb, index)
+};
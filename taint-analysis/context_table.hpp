@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <climits>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "./taint_set.hpp"
+
+using AbsStore = std::map<std::string, TaintSet>; // abs store mapping from variable name to sources that taint them
+using SolnStore = std::map<std::string, TaintSet>;  // sink -> sources
+
+/*
+ * How calling contexts are distinguished: not at all, by the k most recent callsites, or by the callee's entry store
+ * Summary analyzes every function with symbolic taint on its inputs and applies the summary at each call (see
+ * summary_taint.hpp), so a function has a single context like the context insensitive analysis.
+*/
+enum class Sensitivity { ContextInsensitive, Callstring, Functional, Summary };
+
+/*
+ * A (function, context) pair identifying one analysis instance of a function
+ * For context insensitive analysis the context is always ContextTable::kRoot.
+*/
+using ContextKey = std::pair<int, int>;
+
+/*
+ * Interned calling contexts for the context sensitive taint analysis
+ * Functions and callsites (func.bb) are numbered once, and every context is an integer:
+ *  - callstring contexts are hash-consed (callsite, parent context) pairs, so a callstring is a path in a tree
+ *    rooted at kRoot and pushing a callsite with k-limiting is a lookup in a memo table
+ *  - functional contexts are hash-consed abstract stores: structurally equal stores (ignoring untainted
+ *    variables) get the same context
+ * kRoot is the context main starts in.
+ *
+ * To bound memory on recursion heavy programs the number of contexts per function can be capped. Once a function
+ * has max_contexts contexts, every new context of that function is merged into a single per-function merged
+ * context, which sees the join of the stores of all merged callers. Merged contexts (like kRoot and functional
+ * contexts) have no callsite, so callstrings pushed on top of them are kept intact when k-limiting.
+ *
+ * The table is shared by the workers of the parallel solver, so every public method takes the table's lock.
+ * Names live in deques, so the references handed out stay valid as the table grows.
+*/
+class ContextTable {
+    public:
+
+    static constexpr int kRoot = 0;
+
+    ContextTable(int k = 1, int max_contexts = INT_MAX) : k_(k), max_contexts_(max_contexts), contexts_(1, {-1, kRoot}) {}
+
+    int FunctionId(const std::string& func) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = function_ids_.find(func);
+        if (it != function_ids_.end())
+            return it->second;
+        function_ids_[func] = functions_.size();
+        functions_.push_back(func);
+        return functions_.size() - 1;
+    }
+
+    const std::string& FunctionName(int id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return functions_[id];
+    }
+
+    int Callsite(const std::string& func, const std::string& bb) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string name = func + "." + bb;
+        auto it = callsite_ids_.find(name);
+        if (it != callsite_ids_.end())
+            return it->second;
+        callsite_ids_[name] = callsites_.size();
+        callsites_.push_back({func, bb});
+        return callsites_.size() - 1;
+    }
+
+    // (function, basic block) of a callsite
+    const std::pair<std::string, std::string>& CallsiteName(int callsite) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return callsites_[callsite];
+    }
+
+    /*
+     * Callstring context of a callee called at callsite from context ctx, keeping the k most recent callsites
+     */
+    int Push(int ctx, int callsite) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t key = Pack(ctx, callsite);
+        auto it = push_memo_.find(key);
+        if (it != push_memo_.end())
+            return it->second;
+        int callee_ctx = Intern(callsite, Truncate(ctx, k_ - 1));
+        push_memo_[key] = callee_ctx;
+        return callee_ctx;
+    }
+
+    /*
+     * Functional context for a callee entered with the given store
+     */
+    int StoreContext(const AbsStore& store) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        AbsStore normalized;
+        for (const auto& [var, sources] : store) {
+            if (!sources.empty())
+                normalized.insert(normalized.end(), {var, sources});
+        }
+
+        size_t hash = HashStore(normalized);
+        std::vector<int>& bucket = store_buckets_[hash];
+        for (int ctx : bucket) {
+            if (stores_.at(ctx) == normalized)
+                return ctx;
+        }
+        int ctx = NewContext(-1, kRoot);
+        stores_[ctx] = std::move(normalized);
+        bucket.push_back(ctx);
+        return ctx;
+    }
+
+    /*
+     * Context actually used for ctx as a context of func, applying the per-function cap
+     */
+    int Admit(int func, int ctx) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::set<int>& admitted = function_contexts_[func];
+        if (admitted.count(ctx) > 0)
+            return ctx;
+        if (admitted.size() < max_contexts_) {
+            admitted.insert(ctx);
+            return ctx;
+        }
+        merged_away_[func].insert(ctx);
+        auto it = merged_.find(func);
+        if (it != merged_.end())
+            return it->second;
+        int merged = NewContext(-1, kRoot);
+        merged_[func] = merged;
+        admitted.insert(merged);
+        return merged;
+    }
+
+    int NumContexts() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return contexts_.size();
+    }
+
+    /*
+     * Print the number of contexts of every function and how many contexts were merged
+     */
+    void PrintStats(std::ostream& out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int total = 0, merged = 0;
+        for (const auto& [func, admitted] : function_contexts_) {
+            total += admitted.size();
+        }
+        for (const auto& [func, merged_away] : merged_away_) {
+            merged += merged_away.size();
+        }
+        out << "Contexts: " << total << ", merged: " << merged << std::endl;
+
+        std::map<std::string, int> by_name;
+        for (const auto& [func, admitted] : function_contexts_) {
+            by_name[functions_[func]] = func;
+        }
+        for (const auto& [name, func] : by_name) {
+            out << "  " << name << ": " << function_contexts_.at(func).size();
+            if (merged_away_.count(func) > 0)
+                out << " (" << merged_away_.at(func).size() << " merged)";
+            out << std::endl;
+        }
+    }
+
+    private:
+
+    static uint64_t Pack(int a, int b) { return ((uint64_t) (uint32_t) a << 32) | (uint32_t) b; }
+
+    static size_t HashStore(const AbsStore& store) {
+        size_t hash = store.size();
+        std::hash<std::string> hasher;
+        for (const auto& [var, sources] : store) {
+            hash = hash * 31 + hasher(var);
+            hash = hash * 31 + sources.Hash();
+        }
+        return hash;
+    }
+
+    int NewContext(int callsite, int parent) {
+        contexts_.push_back({callsite, parent});
+        return contexts_.size() - 1;
+    }
+
+    int Intern(int callsite, int parent) {
+        uint64_t key = Pack(callsite, parent);
+        auto it = callstring_ids_.find(key);
+        if (it != callstring_ids_.end())
+            return it->second;
+        int ctx = NewContext(callsite, parent);
+        callstring_ids_[key] = ctx;
+        return ctx;
+    }
+
+    // The callstring made of the first depth callsites of ctx; contexts without a callsite are kept whole
+    int Truncate(int ctx, int depth) {
+        if (depth <= 0)
+            return kRoot;
+        const auto [callsite, parent] = contexts_[ctx];
+        if (callsite < 0)
+            return ctx;
+        return Intern(callsite, Truncate(parent, depth - 1));
+    }
+
+    mutable std::mutex mutex_;
+    int k_;
+    int max_contexts_;
+    std::deque<std::string> functions_;
+    std::unordered_map<std::string, int> function_ids_;
+    std::deque<std::pair<std::string, std::string>> callsites_;
+    std::unordered_map<std::string, int> callsite_ids_;
+
+    // context -> (most recent callsite, parent context); (-1, kRoot) for kRoot and functional contexts
+    std::vector<std::pair<int, int>> contexts_;
+    std::unordered_map<uint64_t, int> callstring_ids_;
+    std::unordered_map<uint64_t, int> push_memo_;
+
+    std::unordered_map<size_t, std::vector<int>> store_buckets_;
+    std::unordered_map<int, AbsStore> stores_;
+
+    // function -> contexts admitted so far, its merged context and the contexts merged into it
+    std::unordered_map<int, std::set<int>> function_contexts_;
+    std::unordered_map<int, int> merged_;
+    std::unordered_map<int, std::set<int>> merged_away_;
+};
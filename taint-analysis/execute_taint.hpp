@@ -4,70 +4,49 @@
 #include<set>
 #include<iostream>
 #include "../headers/datatypes.h"
+#include "../headers/points_to_index.hpp"
+#include "./context_table.hpp"
+#include "./taint_spec.hpp"
 #include <deque>
 #include <queue>
 #include <unordered_set>
 #include <unordered_map>
 
-using AbsStore = std::map<std::string, std::set<std::string>>; // abs store mapping from variable name to sources that taint them
-using SolnStore = std::map<std::string, std::set<std::string>>;  // sink -> sources
-
 /*
- * Join is a union of the two abstract stores where each abstract store is a map of variable name to a set of pp where they are defined.
+ * Join is a union of the two abstract stores where each abstract store is a map of variable name to the set of sources that taint it.
+ * Sets are joined in place; a variable that is new to curr_abs_store counts as a change even if untainted.
 */
-bool joinAbsStore(std::map<std::string, std::set<std::string>>&curr_abs_store, std::map<std::string, std::set<std::string>>parent_bb_abs_store) {
+bool joinAbsStore(AbsStore &curr_abs_store, const AbsStore &parent_bb_abs_store) {
     
     bool changed = false;
-    std::map<std::string, std::set<std::string>> result_set;
-    
-    // For elements in curr_abs_store, do a set union with the parent_bb_abs_store
-    // This also handles the case when the key is not present in parent_bb_abs_store but present in curr_abs_store
-    for(auto it = curr_abs_store.begin(); it != curr_abs_store.end(); it++) {
-        std::set<std::string> result_set;
-        std::set_union(it->second.begin(), it->second.end(), parent_bb_abs_store[it->first].begin(), parent_bb_abs_store[it->first].end(), std::inserter(result_set, result_set.begin()));
+    for (const auto& [var, sources] : parent_bb_abs_store) {
+        auto [it, inserted] = curr_abs_store.try_emplace(var, sources);
         // We do not want to unset changed to false if alerady set to true
-        if (!changed)
-            changed = (result_set.size() != it->second.size());
-        it->second = result_set;
-    }
-
-    // For elements in parent_bb_abs_store, if they are not in curr_abs_store, add them to curr_abs_store
-    for(auto it = parent_bb_abs_store.begin(); it != parent_bb_abs_store.end(); it++) {
-        if(curr_abs_store.count(it->first) == 0) {
-            curr_abs_store[it->first] = it->second;
+        if (inserted || it->second.Union(sources))
             changed = true;
-        }
     }
     return changed;
 }
 
-bool joinSets(std::set<std::string> &s1, std::set<std::string> &s2) {
-    bool changed = false;
-    std::set<std::string> result_set;
-    
-    std::set_union(s1.begin(), s1.end(), s2.begin(), s2.end(), std::inserter(result_set, result_set.begin()));
-    
-    changed = (result_set.size() != s1.size());
-    s1 = result_set;
-    return changed;
+bool joinSets(TaintSet &s1, const TaintSet &s2) {
+    return s1.Union(s2);
 }
 
 bool isGlobalVar(Variable *var, Program *program, std::string func_name) {
-    
+    if (var->scope != VarScope::Unknown)
+        return var->IsGlobal();
     if (program->funcs[func_name]->locals.count(var->name) > 0)
         return false;
-
-    for (auto gl : program->globals) {
-        if (gl->globalVar->name == var->name)
-            return true;
-    }
-    return false;
+    return program->global_names.count(var->name) > 0;
 }
 
 /*
 * Get the key for the abstract store
+* Variables of the program carry the key resolved at load time, only ones made up by the analyses are resolved here.
 */
 std::string GetKey(Program* program, Function* func, Variable *var) {
+    if (var->scope != VarScope::Unknown)
+        return var->key;
     if (isGlobalVar(var, program, func->name))
         return var->name;
     else
@@ -83,103 +62,75 @@ std::string GetKey(Program* program, Function* func, Operand *op) {
 
 /*
 * Determine if an extern is a source or a sink
+* taint_spec is set up by main (from --spec or the default src/snk naming) and compiled against the program
+* before the analysis runs.
 */
-// Sink = Any extern function whose name starts with sink_prefix
-bool isSink(Program *program, ExternalFunction *extern_func) {
-    if (extern_func->name.find("snk") != std::string::npos)
-        return true;
-    return false;
+TaintSpec taint_spec;
+
+bool isSink(ExternalFunction *extern_func) {
+    return taint_spec.Rule(extern_func).kind == ExternKind::Sink;
 }
 
-// Source = Any extern function whose name starts with source_prefix
-bool isSource(Program *program, ExternalFunction *extern_func) {
-    if (extern_func->name.find("src") != std::string::npos)
-        return true;
-    return false;
+bool isSource(ExternalFunction *extern_func) {
+    return taint_spec.Rule(extern_func).kind == ExternKind::Source;
 }
 
-std::set<std::string> GetReachable(std::vector<Operand*> args, std::unordered_map<std::string, std::set<std::string>> pointsTo, Program *program, Function* curr_func) {
-    std::set<std::string> reachable;
-    std::queue<std::string> q;
-    std::set<std::string> visited;
+// Rule for the extern called by callext_inst, nullptr if the extern isn't declared
+const ExternRule* GetExternRule(Program *program, CallExtInstruction *callext_inst) {
+    auto it = program->ext_funcs.find(callext_inst->extFuncName);
+    if (it == program->ext_funcs.end())
+        return nullptr;
+    return &taint_spec.Rule(it->second);
+}
 
-    for(const auto& op: args) {
-        if(!op->IsConstInt()) {
-            std::string var = op->var->name;
-            std::string pointsToVarName = isGlobalVar(op->var, program, curr_func->name) ? var : curr_func->name + "." + var;
-
-            if(pointsTo.count(pointsToVarName)) {
-                for(auto v: pointsTo[pointsToVarName]) {
-                    
-                    if (visited.count(v) == 0) {
-                        visited.insert(v);
-                        q.push(v);
-                    }
-                    reachable.insert(v);
+/*
+* Sources are numbered in name order, so iterating a TaintSet visits source names in sorted order
+*/
+std::vector<std::string> source_names;
+std::unordered_map<std::string, int> source_ids;
+
+void NumberSources(Program *program) {
+    std::set<std::string> sources;
+    for (auto [name, ext_func] : program->ext_funcs) {
+        if (isSource(ext_func))
+            sources.insert(name);
+    }
+    source_names.assign(sources.begin(), sources.end());
+    for (int id = 0; id < source_names.size(); id++) {
+        source_ids[source_names[id]] = id;
+    }
+}
 
-                }
+void PrintTaintSet(const TaintSet &sources, std::ostream &out, const char* separator) {
+    bool first = true;
+    sources.ForEach([&](int id) {
+        if (!first)
+            out << separator;
+        out << source_names[id];
+        first = false;
+    });
+}
 
-                while(!q.empty()) {
-
-                    std::string tmp = q.front();
-                    q.pop();
-                    
-                    if(pointsTo.count(tmp)) {
-                        for(auto v: pointsTo[tmp]) {
-                            
-                            if (visited.count(v) == 0) {
-                                visited.insert(v);
-                                q.push(v);
-                            }
-                            reachable.insert(v);
-                        }
-                    }
-                }
-            }
+/*
+* Abstract locations reachable from the arguments through the points-to graph, as PointsToIndex name IDs
+* The closure of every variable is precomputed by the PointsToIndex, so this is just a union of closures.
+*/
+std::vector<int> GetReachable(const std::vector<Operand*>& args, const PointsToIndex& pointsTo, Program *program, Function* curr_func) {
+    std::vector<int> var_ids;
+    for(const auto& op: args) {
+        if(!op->IsConstInt()) {
+            var_ids.push_back(pointsTo.GetId(GetKey(program, curr_func, op->var)));
         }
     }
-    return reachable;
+    return pointsTo.Reachable(var_ids);
 }
 
-std::set<std::string> GetReachable(std::vector<Variable*> params, std::unordered_map<std::string, std::set<std::string>> pointsTo, Program *program, Function* curr_func) {
-    std::set<std::string> reachable;
-    std::queue<std::string> q;
-    std::set<std::string> visited;
-
+std::vector<int> GetReachable(const std::vector<Variable*>& params, const PointsToIndex& pointsTo, Program *program, Function* curr_func) {
+    std::vector<int> var_ids;
     for(const auto& param: params) {
-        std::string var = param->name;
-        std::string pointsToVarName = isGlobalVar(param, program, curr_func->name) ? var : curr_func->name + "." + var;
-
-        if(pointsTo.count(pointsToVarName)) {
-            for(auto v: pointsTo[pointsToVarName]) {
-                
-                if (visited.count(v) == 0) {
-                    visited.insert(v);
-                    q.push(v);
-                }
-                reachable.insert(v);
-
-            }
-
-            while(!q.empty()) {
-
-                std::string tmp = q.front();
-                q.pop();
-                
-                if(pointsTo.count(tmp)) {
-                    for(auto v: pointsTo[tmp]) {
-                        
-                        if (visited.count(v) == 0) {
-                            visited.insert(v);
-                            q.push(v);
-                        }
-                        reachable.insert(v);
-                    }
-                }
-            }
-        }
+        var_ids.push_back(pointsTo.GetId(GetKey(program, curr_func, param)));
     }
-    return reachable;
+    return pointsTo.Reachable(var_ids);
 }
 
 /*
@@ -191,7 +142,7 @@ std::set<std::string> GetReachable(std::vector<Variable*> params, std::unordered
                     {} if op is a constant
                 }
 */
-std::set<std::string> taint(Operand *op, AbsStore &store, std::string key) {
+TaintSet taint(Operand *op, AbsStore &store, std::string key) {
     if (op->IsConstInt())
         return {};
     else
@@ -207,212 +158,386 @@ std::set<std::string> taint(Operand *op, AbsStore &store, std::string key) {
 * GetReturnedStore : (pointoTo, curr abs store, curr func, ret op? if present) -> abs store
 * GetCallerStore : (store, call lhs if present) -> abs store
 */
-AbsStore GetCalleeStore(Program *program, std::unordered_map<std::string, std::set<std::string>> pointsTo, AbsStore curr_store, std::string callee, std::vector<Operand*> args, Function* func) {
+AbsStore GetCalleeStore(Program *program, const PointsToIndex& pointsTo, const AbsStore& curr_store, const std::string& callee, const std::vector<Operand*>& args, Function* func) {
 
     // 1. Map each callee parameter to abstract store of the corresponding argumentg
     AbsStore callee_store = {};
     Function *callee_func = program->funcs[callee];
     for (int i = 0; i < args.size(); i++) {
-        std::string key = GetKey(program, func, args[i]);
-        if (!args[i]->IsConstInt() && curr_store[key].size() > 0)
-            callee_store[callee + "." + callee_func->params[i]->name] = curr_store[key];
+        if (args[i]->IsConstInt())
+            continue;
+        auto arg = curr_store.find(GetKey(program, func, args[i]));
+        if (arg != curr_store.end() && !arg->second.empty())
+            callee_store[callee + "." + callee_func->params[i]->name] = arg->second;
     }
     // 2. Copy each element reachable from args
-    std::set<std::string> reachable = GetReachable(args, pointsTo, program, func);
-    for (auto it = reachable.begin(); it != reachable.end(); it++) {
-        joinSets(callee_store[*it], curr_store[*it]);
+    for (int id : GetReachable(args, pointsTo, program, func)) {
+        TaintSet& callee_sources = callee_store[pointsTo.Name(id)];
+        auto sources = curr_store.find(pointsTo.Name(id));
+        if (sources != curr_store.end())
+            joinSets(callee_sources, sources->second);
     }
 
     return callee_store;
 }
 
-AbsStore GetReturnedStore(Program *program, std::unordered_map<std::string, std::set<std::string>> pointsTo, AbsStore curr_store, Function *curr_func, Operand* ret_op) {
+AbsStore GetReturnedStore(Program *program, const PointsToIndex& pointsTo, const AbsStore& curr_store, Function *curr_func, Operand* ret_op) {
     
     AbsStore returned_store = {};
 
     // 1. Add all elements of current store reachable from a parameter
-    std::set<std::string> reachable = GetReachable(curr_func->params, pointsTo, program, curr_func);
-    for (auto it = reachable.begin(); it != reachable.end(); it++) {
-        if (curr_store.find(*it) != curr_store.end()) {
-            returned_store[*it] = curr_store[*it];
+    for (int id : GetReachable(curr_func->params, pointsTo, program, curr_func)) {
+        auto sources = curr_store.find(pointsTo.Name(id));
+        if (sources != curr_store.end()) {
+            returned_store[pointsTo.Name(id)] = sources->second;
         }
     }
 
     // 2. Add all elements of current store reachable from the return operand
     if (ret_op != nullptr && !ret_op->IsConstInt()) {
         std::string ret_op_key = GetKey(program, curr_func, ret_op->var);
-        for (auto points_to: pointsTo[ret_op_key]) {
-            returned_store[points_to] = curr_store[points_to];
+        for (auto points_to: pointsTo.PointsTo(ret_op_key)) {
+            auto sources = curr_store.find(points_to);
+            returned_store[points_to] = sources != curr_store.end() ? sources->second : TaintSet();
         }
         
         // 3. Placeholde FAKE for lhs of return instruction
-        if (curr_store.find(ret_op_key) != curr_store.end()) {
-            returned_store["FAKE"] = curr_store[ret_op_key];
+        auto ret_sources = curr_store.find(ret_op_key);
+        if (ret_sources != curr_store.end()) {
+            returned_store["FAKE"] = ret_sources->second;
         }
     }
 
     return returned_store;
 }
 
-AbsStore GetCallerStore(Program *program, AbsStore curr_store, Variable* call_lhs, Function *caller_func) {
+AbsStore GetCallerStore(Program *program, const AbsStore& curr_store, Variable* call_lhs, Function *caller_func) {
 
     AbsStore caller_store = curr_store;
+    auto fake = caller_store.find("FAKE");
+    if (fake == caller_store.end())
+        return caller_store;
     if (call_lhs != nullptr) {
         std::string call_lhs_key = GetKey(program, caller_func, call_lhs);
-        if (curr_store.find("FAKE") != curr_store.end()) {
-            caller_store[call_lhs_key] = curr_store["FAKE"];
-            caller_store.erase("FAKE");
-        }
-    }
-    else {
-        if (caller_store.find("FAKE") != caller_store.end())
-            caller_store.erase("FAKE");
+        caller_store[call_lhs_key] = fake->second;
     }
+    caller_store.erase("FAKE");
     return caller_store;
 }
 
 
-void PrintAbsStore(AbsStore store)
+void PrintAbsStore(const AbsStore& store)
 {
     for (auto it = store.begin(); it != store.end(); it++)
     {
         std::cout << it->first << " : ";
-        for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++)
-        {
-            std::cout << *it2 << ",";
-        }
+        PrintTaintSet(it->second, std::cout, ",");
         std::cout << std::endl;
     }
 }
 
 /*
- * The callstring stack is a string of the form "func1.bbx#func2.bby#func3.bbz#func1.bba...."
- * The first function is top of the stack and the last function is the bottom of the stack
-*/ 
-
-std::string AddToCurrentContext(std::string callsite, int sensitivity, std::string curr_context, int k = 1000) {
-    
-    std::string callstring;
+* Store keys that can ever be tainted, for sparse taint propagation
+* Flow insensitive forward closure from the source calls (their lhs and everything reachable from their args)
+* along the def-use edges of the transfer functions, the points-to edges of loads and stores, and the
+* argument -> parameter and return -> call lhs edges of calls. Keys outside the set are always untainted, so
+* sparse mode skips the instructions defining them and never stores them.
+*/
+std::unordered_set<std::string> ComputeTaintableKeys(Program *program, const PointsToIndex& pointsTo) {
+    std::unordered_set<std::string> taintable;
+    bool changed = true;
+
+    auto tainted = [&](Function *func, Operand *op) {
+        return !op->IsConstInt() && taintable.count(GetKey(program, func, op->var)) > 0;
+    };
+    auto add = [&](const std::string &key) {
+        if (taintable.insert(key).second)
+            changed = true;
+    };
+    // Parameters of a callee reached with a tainted argument, and lhs of the call if the callee returns taint
+    auto call = [&](Function *func, const std::string &callee, std::vector<Operand*> &args, Variable *lhs) {
+        if (program->funcs.count(callee) == 0)
+            return;
+        Function *callee_func = program->funcs[callee];
+        for (int i = 0; i < args.size() && i < callee_func->params.size(); i++) {
+            if (tainted(func, args[i]))
+                add(callee + "." + callee_func->params[i]->name);
+        }
+        if (lhs == nullptr)
+            return;
+        for (auto [label, callee_bb] : callee_func->bbs) {
+            if (callee_bb->terminal->instrType != InstructionType::RetInstrType)
+                continue;
+            Operand *ret_op = ((RetInstruction *) callee_bb->terminal)->op;
+            if (ret_op != nullptr && tainted(callee_func, ret_op))
+                add(GetKey(program, func, lhs));
+        }
+    };
+
+    while (changed) {
+        changed = false;
+        for (auto [func_name, func] : program->funcs) {
+            for (auto [label, bb] : func->bbs) {
+                for (Instruction *inst : bb->instructions) {
+                    switch (inst->instrType) {
+                        case InstructionType::ArithInstrType: {
+                            ArithInstruction *arith_inst = (ArithInstruction *) inst;
+                            if (tainted(func, arith_inst->op1) || tainted(func, arith_inst->op2))
+                                add(GetKey(program, func, arith_inst->lhs));
+                            break;
+                        }
+                        case InstructionType::CmpInstrType: {
+                            CmpInstruction *cmp_inst = (CmpInstruction *) inst;
+                            if (tainted(func, cmp_inst->op1) || tainted(func, cmp_inst->op2))
+                                add(GetKey(program, func, cmp_inst->lhs));
+                            break;
+                        }
+                        case InstructionType::CopyInstrType: {
+                            CopyInstruction *copy_inst = (CopyInstruction *) inst;
+                            if (tainted(func, copy_inst->op))
+                                add(GetKey(program, func, copy_inst->lhs));
+                            break;
+                        }
+                        case InstructionType::GepInstrType: {
+                            GepInstruction *gep_inst = (GepInstruction *) inst;
+                            if (taintable.count(GetKey(program, func, gep_inst->src)) > 0 || tainted(func, gep_inst->idx))
+                                add(GetKey(program, func, gep_inst->lhs));
+                            break;
+                        }
+                        case InstructionType::GfpInstrType: {
+                            GfpInstruction *gfp_inst = (GfpInstruction *) inst;
+                            if (taintable.count(GetKey(program, func, gfp_inst->src)) > 0)
+                                add(GetKey(program, func, gfp_inst->lhs));
+                            break;
+                        }
+                        case InstructionType::LoadInstrType: {
+                            LoadInstruction *load_inst = (LoadInstruction *) inst;
+                            std::string src_key = GetKey(program, func, load_inst->src);
+                            bool src_tainted = taintable.count(src_key) > 0;
+                            for (auto pointed_to : pointsTo.PointsTo(src_key)) {
+                                src_tainted = src_tainted || taintable.count(pointed_to) > 0;
+                            }
+                            if (src_tainted)
+                                add(GetKey(program, func, load_inst->lhs));
+                            break;
+                        }
+                        case InstructionType::StoreInstrType: {
+                            StoreInstruction *store_inst = (StoreInstruction *) inst;
+                            std::string dst_key = GetKey(program, func, store_inst->dst);
+                            if (tainted(func, store_inst->op) || taintable.count(dst_key) > 0) {
+                                for (auto pointed_to : pointsTo.PointsTo(dst_key))
+                                    add(pointed_to);
+                            }
+                            break;
+                        }
+                        case InstructionType::CallExtInstrType: {
+                            CallExtInstruction *callext_inst = (CallExtInstruction *) inst;
+                            const ExternRule *rule = GetExternRule(program, callext_inst);
+                            if (rule == nullptr)
+                                break;
+                            if (rule->kind == ExternKind::Source) {
+                                if (callext_inst->lhs)
+                                    add(GetKey(program, func, callext_inst->lhs));
+                                for (int id : GetReachable(callext_inst->args, pointsTo, program, func)) {
+                                    add(pointsTo.Name(id));
+                                }
+                            }
+                            else if (rule->kind == ExternKind::Other) {
+                                const std::vector<Operand*> &args = callext_inst->args;
+                                for (auto [from, to] : rule->flows) {
+                                    if (from >= args.size() || args[from]->IsConstInt())
+                                        continue;
+                                    bool from_tainted = tainted(func, args[from]);
+                                    for (int id : GetReachable({args[from]}, pointsTo, program, func)) {
+                                        from_tainted = from_tainted || taintable.count(pointsTo.Name(id)) > 0;
+                                    }
+                                    if (!from_tainted)
+                                        continue;
+                                    if (to == ExternRule::kReturn) {
+                                        if (callext_inst->lhs)
+                                            add(GetKey(program, func, callext_inst->lhs));
+                                    }
+                                    else if (to < args.size() && !args[to]->IsConstInt()) {
+                                        for (int id : GetReachable({args[to]}, pointsTo, program, func)) {
+                                            add(pointsTo.Name(id));
+                                        }
+                                    }
+                                }
+                            }
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                }
 
-    if (sensitivity == 1)
-    {
-        // For callstring-1 sensitivity, we need to maintain a callstring stack of size 1.
-        callstring = callsite;
-    }
-    else if (sensitivity == 2)
-    {
-        // For callstring-2 sensitivity, we need to maintain a callstring stack of size 2.
-        // IF the size is already 2, then we drop the bottom of the stack and add the new function to the top of the stack
-        if (curr_context.size() > 0)
-        {
-            // Already has 2 callsites => we need to drop the bottom callsite
-            if (curr_context.find("#") != std::string::npos)
-            {
-                int index = curr_context.find("#");
-                std::string first_callsite = curr_context.substr(0, index);
-                callstring = callsite + "#" + first_callsite;
-            }
-            // Only 1 callsite => we add the new callsite to the top of the stack
-            else
-            {
-                callstring = callsite + "#" + curr_context;
+                if (bb->terminal->instrType == InstructionType::CallDirInstrType) {
+                    CallDirInstruction *calldir_inst = (CallDirInstruction *) bb->terminal;
+                    call(func, calldir_inst->callee, calldir_inst->args, calldir_inst->lhs);
+                }
+                else if (bb->terminal->instrType == InstructionType::CallIdrInstrType) {
+                    CallIdrInstruction *callidr_inst = (CallIdrInstruction *) bb->terminal;
+                    for (auto callee : pointsTo.PointsTo(GetKey(program, func, callidr_inst->fp)))
+                        call(func, callee, callidr_inst->args, callidr_inst->lhs);
+                }
             }
         }
-        else 
-        {
-            callstring = callsite;
-        }
     }
-    else if (sensitivity > 0)
-    {
-        // Construct callstring for stack of size k
-        // Count the number of # in context. If # == k-1 => we need to drop the last callsite
-        int count = 0;
-        for (int i = 0; i < curr_context.size(); i++)
-        {
-            if (curr_context[i] == '#')
-                count++;
-        }
-        // Get last callsite i.e string after last #
-        std::string last_callsite = "";
-        if (count == k-1)
-        {
-            int index = curr_context.find_last_of("#");
-            last_callsite = curr_context.substr(index+1);
-            callstring = callsite + "#" + curr_context.substr(0, index);
-        }
-        else
-        {
-            callstring = callsite + "#" + curr_context;
+    return taintable;
+}
+
+/*
+* Sparse mode only: true if the instruction can be skipped because everything it defines is always untainted
+*/
+bool IsUntaintedDef(Program *program, Function *func, const Instruction *inst, const std::unordered_set<std::string> &taintable) {
+    auto untainted = [&](Variable *var) { return taintable.count(GetKey(program, func, var)) == 0; };
+    switch (inst->instrType) {
+        case InstructionType::ArithInstrType: return untainted(((ArithInstruction *) inst)->lhs);
+        case InstructionType::CmpInstrType: return untainted(((CmpInstruction *) inst)->lhs);
+        case InstructionType::CopyInstrType: return untainted(((CopyInstruction *) inst)->lhs);
+        case InstructionType::AllocInstrType: return untainted(((AllocInstruction *) inst)->lhs);
+        case InstructionType::GepInstrType: return untainted(((GepInstruction *) inst)->lhs);
+        case InstructionType::GfpInstrType: return untainted(((GfpInstruction *) inst)->lhs);
+        case InstructionType::AddrofInstrType: return untainted(((AddrofInstruction *) inst)->lhs);
+        case InstructionType::LoadInstrType: return untainted(((LoadInstruction *) inst)->lhs);
+        case InstructionType::StoreInstrType: {
+            StoreInstruction *store_inst = (StoreInstruction *) inst;
+            return untainted(store_inst->dst) && (store_inst->op->IsConstInt() || untainted(store_inst->op->var));
         }
+        default: return false;
     }
-    return callstring;
 }
 
 /*
-* Maintain a map from abstract store string to a unique integer
-* Maintain a map from integer to abstract store string
+* Context of the callee called at callsite from context curr_cid
+* For callstring sensitivity it is the callsite pushed onto the k-limited callstring, for functional sensitivity
+* it is the store the callee is entered with. Past the per-function cap the callee gets its merged context.
 */
-std::map<std::string, int> store2int;
-std::map<int, std::string> int2store;
-static int store_count = 0;
-
-std::string AbsStoreToString(AbsStore store) {
-    std::string store_str = "";
-    for (auto it = store.begin(); it != store.end(); it++) {
-        if (it->second.size() == 0)
+int GetCalleeContext(ContextTable& contexts, Sensitivity sensitivity, int callee, int callsite, int curr_cid, const AbsStore& callee_store) {
+    int callee_cid = ContextTable::kRoot;
+    if (sensitivity == Sensitivity::Callstring)
+        callee_cid = contexts.Push(curr_cid, callsite);
+    else if (sensitivity == Sensitivity::Functional)
+        callee_cid = contexts.StoreContext(callee_store);
+    return contexts.Admit(callee, callee_cid);
+}
+
+/*
+* Sparse join: only the tainted entries of store are added, in place
+*/
+bool joinSparseAbsStore(AbsStore &curr_abs_store, const AbsStore &store) {
+    bool changed = false;
+    for (const auto& [var, sources] : store) {
+        if (sources.empty())
             continue;
-        store_str += it->first + ":{";
-        for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++) {
-            store_str += *it2 + ",";
-        }
-        store_str += "};";
+        if (curr_abs_store[var].Union(sources))
+            changed = true;
     }
-    return store_str;
+    return changed;
 }
 
 /*
-* Returns context for functional context sensitive analysis
-* The context is a the current abstract store
-* To make it easier to store and compare, we convert the store to a string and return the corresponding integer for the string
+* State of the taint fixpoint: block stores, worklist, call edges and returned stores, and the solution
+* execute only goes through the virtual accessors, so ParallelTaintState can share this code and override
+* them with per-context locking.
 */
-std::string GetFunctionalContext(AbsStore callee_store) {
-    // Map the abstract store to a string
-    // Convert abstract store to it's equivalent string representation
-    std::string callee_store_str = AbsStoreToString(callee_store);
-
-    // If the store is already present in the map, then return the corresponding integer
-    if (store2int.count(callee_store_str) > 0) {
-        return std::to_string(store2int[callee_store_str]);
+class TaintState {
+    public:
+
+    TaintState(bool sparse) : sparse(sparse) {}
+    virtual ~TaintState() = default;
+
+    /*
+    * Add (key, label) to the worklist as visited, whatever its store
+    */
+    virtual void Seed(const ContextKey& key, const std::string& label) {
+        bbs_to_output.insert({key, label});
+        worklist.push_back({key, label});
     }
-    // Else, add the store to the map and return the corresponding integer
-    else {
-        store2int[callee_store_str] = store_count;
-        int2store[store_count] = callee_store_str;
-        store_count++;
-        return std::to_string(store2int[callee_store_str]);
+
+    /*
+    * Input store of a block
+    */
+    virtual AbsStore BlockStore(const ContextKey& key, const std::string& label) {
+        return bb2store[key][label];
     }
-}
 
+    /*
+    * Join store into bb2store[key][label] and add (key, label) to the worklist if it changed or was never visited
+    * In sparse mode block states only keep tainted entries.
+    */
+    virtual void Propagate(const ContextKey& key, const std::string& label, const AbsStore& store) {
+        AbsStore &bb_store = bb2store[key][label];
+        bool changed = sparse ? joinSparseAbsStore(bb_store, store) : joinAbsStore(bb_store, store);
+        if (changed || bbs_to_output.count({key, label}) == 0)
+        {
+            bbs_to_output.insert({key, label});
+            worklist.push_back({key, label});
+        }
+    }
+
+    /*
+    * Record a call to callee_key from (callsite, caller_cid), returns what the callee has returned so far
+    */
+    virtual AbsStore AddCallEdge(const ContextKey& callee_key, int callsite, int caller_cid) {
+        call_edges[callee_key].insert({callsite, caller_cid});
+        return call_returned[callee_key];
+    }
+
+    /*
+    * Call to callee_key from (callsite, caller_cid) entering it with callee_store
+    * Records the call edge, propagates callee_store to the callee's entry and returns what the callee has
+    * returned so far.
+    */
+    virtual AbsStore Call(const ContextKey& callee_key, int callsite, int caller_cid, const AbsStore& callee_store) {
+        AbsStore returned_store = AddCallEdge(callee_key, callsite, caller_cid);
+        Propagate(callee_key, "entry", callee_store);
+        return returned_store;
+    }
+
+    /*
+    * Join the store returned by key into what it returned so far (a function may return from several blocks),
+    * returns the (callsite, caller context) pairs to return it to
+    */
+    virtual std::set<std::pair<int, int>> SetReturned(const ContextKey& key, const AbsStore& ret_store) {
+        joinAbsStore(call_returned[key], ret_store);
+        return call_edges[key];
+    }
+
+    virtual void AddToSoln(const std::string& sink, const TaintSet& sources) {
+        joinSets(soln[sink], sources);
+    }
+
+    virtual void Log(const std::string& message) {
+        std::cout << message << std::endl;
+    }
+
+    bool sparse;
+    std::map<ContextKey, std::map<std::string, AbsStore>> bb2store; // (function, context) -> bb -> variable -> set of sources
+    std::deque<std::pair<ContextKey, std::string>> worklist;
+    std::set<std::pair<ContextKey, std::string>> bbs_to_output;
+    SolnStore soln;
+    // call_edges is a map from (function,cid) -> set of (callsite, caller cid) pairs that call it
+    // For context insensitive analysis the cid part of the key is always kRoot
+    std::map<ContextKey, std::set<std::pair<int, int>>> call_edges;
+    // call_returned is a map from (function,cid) -> returned abstract store
+    std::map<ContextKey, AbsStore> call_returned;
+};
 
 void execute(
     Program *program,
     Function* func,
-    std::string curr_cid, // contains current context - For context insensitive analysis, it is empty. For callstring - it the the callstring stack, for functional it is a unique integer representing the abstract store
+    int curr_cid, // current context - kRoot for context insensitive analysis, an interned callstring or store otherwise
     BasicBlock *bb,
-    std::map<std::string, std::map<std::string, AbsStore>> &bb2store, // function -> bb -> variable -> set of sources
-    std::deque<std::pair<std::string, std::string>> &worklist,
-    std::set<std::string> &bbs_to_output,
-    std::map<std::string, std::set<std::string>> &soln,
-    std::unordered_map<std::string, std::set<std::string>> pointsTo,
-    std::map<std::pair<std::string, std::string>, std::set<std::pair<std::string,std::string>>> &call_edges,
-    std::map<std::pair<std::string, std::string>, AbsStore> &call_returned,
-    int sensitivity
+    TaintState &state,
+    const PointsToIndex& pointsTo,
+    ContextTable &contexts,
+    Sensitivity sensitivity,
+    const std::unordered_set<std::string> *taintable = nullptr // sparse mode: keys that can be tainted
 )
 {
-    AbsStore sigma_prime = bb2store[func->name][bb->label]; 
-    if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3)
-        sigma_prime = bb2store[func->name + "|" + curr_cid][bb->label]; // For callstring and functional sensitivity, we need to maintain a separate store for each context (cid
+    ContextKey curr_key = {contexts.FunctionId(func->name), curr_cid};
+    AbsStore sigma_prime = state.BlockStore(curr_key, bb->label);
     int index = 0; // To help build program point name
 
     /*
@@ -420,6 +545,11 @@ void execute(
      */
     for (const Instruction *inst : bb->instructions) {
 
+        if (taintable != nullptr && IsUntaintedDef(program, func, inst, *taintable)) {
+            index += 1;
+            continue;
+        }
+
         std::string pp = func->name + "." + bb->label + "." + std::to_string(index);
 
         if ((*inst).instrType == InstructionType::ArithInstrType) 
@@ -430,8 +560,8 @@ void execute(
              * x = $arith add y z
              * sigma_prime[x] = taint(op1) U taint(op2)
             */
-            std::set<std::string> taint_op1 = taint(arith_inst->op1, sigma_prime, GetKey(program, func, arith_inst->op1)); // TODO - Verify that is sigma_prime and not bb2store 
-            std::set<std::string> taint_op2 = taint(arith_inst->op2, sigma_prime, GetKey(program, func, arith_inst->op2));
+            TaintSet taint_op1 = taint(arith_inst->op1, sigma_prime, GetKey(program, func, arith_inst->op1)); // TODO - Verify that is sigma_prime and not bb2store 
+            TaintSet taint_op2 = taint(arith_inst->op2, sigma_prime, GetKey(program, func, arith_inst->op2));
             joinSets(taint_op1, taint_op2);
             sigma_prime[GetKey(program, func, arith_inst->lhs)] = taint_op1;
 
@@ -444,8 +574,8 @@ void execute(
              * x = $cmp gt y z
              * sigma_prime[x] = taint(op1) U taint(op2)
             */
-            std::set<std::string> taint_op1 = taint(cmp_inst->op1, sigma_prime, GetKey(program, func, cmp_inst->op1));
-            std::set<std::string> taint_op2 = taint(cmp_inst->op2, sigma_prime, GetKey(program, func, cmp_inst->op2));
+            TaintSet taint_op1 = taint(cmp_inst->op1, sigma_prime, GetKey(program, func, cmp_inst->op1));
+            TaintSet taint_op2 = taint(cmp_inst->op2, sigma_prime, GetKey(program, func, cmp_inst->op2));
             
             joinSets(taint_op1, taint_op2);
             
@@ -482,8 +612,8 @@ void execute(
              * x = $gep y op
              * sigma_prime[x] = taint(op) U taint(y)
             */
-            std::set<std::string> taint_y = sigma_prime[GetKey(program, func, gep_inst->src)];
-            std::set<std::string> taint_op = taint(gep_inst->idx, sigma_prime, GetKey(program, func, gep_inst->idx));
+            TaintSet taint_y = sigma_prime[GetKey(program, func, gep_inst->src)];
+            TaintSet taint_op = taint(gep_inst->idx, sigma_prime, GetKey(program, func, gep_inst->idx));
             
             joinSets(taint_op, taint_y);
             
@@ -519,9 +649,9 @@ void execute(
              * sigma_prime[x] = taint(y) U (for all v in ptsto(y): taint(v))
             */
             std::string pointsToKey = GetKey(program, func, load_inst->src);
-            std::set<std::string> taint_y = sigma_prime[pointsToKey];
+            TaintSet taint_y = sigma_prime[pointsToKey];
             
-            for (auto pointed_to: pointsTo[pointsToKey]) {
+            for (auto pointed_to: pointsTo.PointsTo(pointsToKey)) {
                 joinSets(taint_y, sigma_prime[pointed_to]);
             }
             
@@ -535,12 +665,12 @@ void execute(
              * for all v in ptsto(x): sigma_prime[v] = sigma_prime[v] U (taint(op) U taint(x))
             */
             std::string pointsToKey = GetKey(program, func, store_inst->dst);
-            std::set<std::string> taint_op = taint(store_inst->op, sigma_prime, GetKey(program, func, store_inst->op));
-            std::set<std::string> taint_x = sigma_prime[pointsToKey];
+            TaintSet taint_op = taint(store_inst->op, sigma_prime, GetKey(program, func, store_inst->op));
+            TaintSet taint_x = sigma_prime[pointsToKey];
             
             joinSets(taint_op, taint_x);
 
-            for (auto pointed_to: pointsTo[pointsToKey]) {
+            for (auto pointed_to: pointsTo.PointsTo(pointsToKey)) {
                 joinSets(sigma_prime[pointed_to], taint_op);
             }
         }
@@ -555,37 +685,53 @@ void execute(
              * else if f = sink :
              *    for all v in reachable(args), soln[<sink>] = soln[<sink>] U sigma_prime[v] - Can be done once in the end
              *    sigma_prime[x] = {}
-             * else:
+             * else if f = sanitizer :
+             *    for all v in reachable(args), sigma_prime[v] = {}
              *    sigma_prime[x] = {}
+             * else:
+             *    sigma_prime[x] = U taint(args[from]) for the spec's (from, ret) rules of f
+             *    for all (from, to) rules of f, for all v in reachable(args[to]), sigma_prime[v] U= taint(args[from])
+             *    where taint(arg) includes everything reachable from arg
             */
 
-            if (program->ext_funcs.find(callext_inst->extFuncName) != program->ext_funcs.end() && 
-                isSource(program, program->ext_funcs[callext_inst->extFuncName]))
+            const ExternRule *rule = GetExternRule(program, callext_inst);
+            ExternKind kind = rule ? rule->kind : ExternKind::Other;
+
+            if (kind == ExternKind::Source)
             {
                 if (callext_inst->lhs) {
                     std::string lhsKey = GetKey(program, func, callext_inst->lhs);
-                    sigma_prime[lhsKey] = {callext_inst->extFuncName};
+                    sigma_prime[lhsKey] = TaintSet::Of(source_ids.at(callext_inst->extFuncName));
                 }
 
-                std::set<std::string> reachable = GetReachable(callext_inst->args, pointsTo, program, func);
-                for (std::string v : reachable) {
-                    std::set<std::string> sources_set = {callext_inst->extFuncName};
-                    joinSets(sigma_prime[v], sources_set);
+                TaintSet source = TaintSet::Of(source_ids.at(callext_inst->extFuncName));
+                for (int id : GetReachable(callext_inst->args, pointsTo, program, func)) {
+                    joinSets(sigma_prime[pointsTo.Name(id)], source);
                 }
             }
-            else if (program->ext_funcs.find(callext_inst->extFuncName) != program->ext_funcs.end() && 
-                isSink(program, program->ext_funcs[callext_inst->extFuncName])) {
-                std::set<std::string> reachable = GetReachable(callext_inst->args, pointsTo, program, func);
-                
-                for (std::string v : reachable) {
-                    joinSets(soln[callext_inst->extFuncName], sigma_prime[v]);
+            else if (kind == ExternKind::Sink) {
+                for (int id : GetReachable(callext_inst->args, pointsTo, program, func)) {
+                    state.AddToSoln(callext_inst->extFuncName, sigma_prime[pointsTo.Name(id)]);
                 }
 
                 for (auto v: callext_inst->args) {
                     if (v->IsConstInt())
                         continue;
                     std::string v_key = GetKey(program, func, v->var);
-                    joinSets(soln[callext_inst->extFuncName], sigma_prime[v_key]);
+                    state.AddToSoln(callext_inst->extFuncName, sigma_prime[v_key]);
+                }
+
+                if (callext_inst->lhs) {
+                    std::string lhsKey = GetKey(program, func, callext_inst->lhs);
+                    sigma_prime[lhsKey] = {};
+                }
+            }
+            else if (kind == ExternKind::Sanitizer) {
+                // A sanitizer cleans what its arguments point to in place and returns clean data
+                for (int id : GetReachable(callext_inst->args, pointsTo, program, func)) {
+                    auto it = sigma_prime.find(pointsTo.Name(id));
+                    if (it != sigma_prime.end())
+                        it->second = {};
                 }
 
                 if (callext_inst->lhs) {
@@ -593,8 +739,47 @@ void execute(
                     sigma_prime[lhsKey] = {};
                 }
             }
+            else if (rule != nullptr && !rule->flows.empty()) {
+                const std::vector<Operand*> &args = callext_inst->args;
+                auto arg_taint = [&](int arg) {
+                    TaintSet taint_arg;
+                    if (arg >= args.size() || args[arg]->IsConstInt())
+                        return taint_arg;
+                    auto it = sigma_prime.find(GetKey(program, func, args[arg]->var));
+                    if (it != sigma_prime.end())
+                        taint_arg.Union(it->second);
+                    for (int id : GetReachable({args[arg]}, pointsTo, program, func)) {
+                        auto it = sigma_prime.find(pointsTo.Name(id));
+                        if (it != sigma_prime.end())
+                            taint_arg.Union(it->second);
+                    }
+                    return taint_arg;
+                };
+
+                // Read every argument before writing any location, so the rules see the store before the call
+                TaintSet taint_ret;
+                std::vector<std::pair<int, TaintSet>> taint_out;
+                for (auto [from, to] : rule->flows) {
+                    if (to == ExternRule::kReturn)
+                        taint_ret.Union(arg_taint(from));
+                    else if (to < args.size() && !args[to]->IsConstInt())
+                        taint_out.push_back({to, arg_taint(from)});
+                }
+                for (const auto& [to, taint_from] : taint_out) {
+                    if (taint_from.empty())
+                        continue;
+                    for (int id : GetReachable({args[to]}, pointsTo, program, func)) {
+                        joinSets(sigma_prime[pointsTo.Name(id)], taint_from);
+                    }
+                }
+
+                if (callext_inst->lhs) {
+                    std::string lhsKey = GetKey(program, func, callext_inst->lhs);
+                    sigma_prime[lhsKey] = taint_ret;
+                }
+            }
             else {
-                std::cout << "Neither source nor sink " << callext_inst->extFuncName << std::endl;
+                state.Log("Neither source nor sink " + callext_inst->extFuncName);
                 if (callext_inst->lhs) {
                     std::string lhsKey = GetKey(program, func, callext_inst->lhs);
                     sigma_prime[lhsKey] = {};
@@ -613,64 +798,15 @@ void execute(
     {
         JumpInstruction *jump_inst = (JumpInstruction *) terminal_instruction;
 
-        std::string bbs_to_output_key = func->name + "|" + jump_inst->label;
-        std::string context = func->name;
-
         // Propagate store to jump label
-        if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-            context = func->name + "|" + curr_cid;
-            bbs_to_output_key = func->name + "|" + curr_cid + "|" + jump_inst->label;
-        }
-        
-        if (joinAbsStore(bb2store[context][jump_inst->label], sigma_prime) || 
-            bbs_to_output.count(bbs_to_output_key) == 0)
-        {
-            bbs_to_output.insert(bbs_to_output_key);
-            if (sensitivity > 0)
-                worklist.push_back({func->name + "|" + curr_cid, jump_inst->label});
-            else
-                worklist.push_back({func->name, jump_inst->label});
-        }
+        state.Propagate(curr_key, jump_inst->label, sigma_prime);
     }
     else if ((*terminal_instruction).instrType == InstructionType::BranchInstrType)
     {
         BranchInstruction *branch_inst = (BranchInstruction *) terminal_instruction;
 
-        std::string bbs_to_output_key_tt = func->name + "|" + branch_inst->tt;
-        std::string bbs_to_output_key_ff = func->name + "|" + branch_inst->ff;
-
-        if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-            bbs_to_output_key_tt = func->name + "|" + curr_cid + "|" + branch_inst->tt;
-            bbs_to_output_key_ff = func->name + "|" + curr_cid + "|" + branch_inst->ff;
-        }
-
-        std::string context = func->name;
-        if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3)
-            context = func->name + "|" + curr_cid;
-        if (joinAbsStore(bb2store[context][branch_inst->tt], sigma_prime) ||
-            bbs_to_output.count(bbs_to_output_key_tt) == 0)
-        {
-            bbs_to_output.insert(bbs_to_output_key_tt);
-            if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3)
-            {
-                worklist.push_back({func->name + "|" + curr_cid, branch_inst->tt});
-                //std::cout << "Adding to worklist: " << func->name + "|" + curr_cid << " " << branch_inst->tt << std::endl;
-            }
-            else
-                worklist.push_back({func->name, branch_inst->tt});
-        }
-
-        if (joinAbsStore(bb2store[context][branch_inst->ff], sigma_prime) ||
-            bbs_to_output.count(bbs_to_output_key_ff) == 0)
-        {
-            bbs_to_output.insert(bbs_to_output_key_ff);
-            if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-                worklist.push_back({func->name + "|" + curr_cid, branch_inst->ff});
-                //std::cout << "Adding to worklist: " << func->name + "|" + curr_cid << " " << branch_inst->ff << std::endl;
-            }
-            else
-                worklist.push_back({func->name, branch_inst->ff});
-        }
+        state.Propagate(curr_key, branch_inst->tt, sigma_prime);
+        state.Propagate(curr_key, branch_inst->ff, sigma_prime);
     }
     else if ((*terminal_instruction).instrType == InstructionType::RetInstrType)
     {
@@ -688,20 +824,12 @@ void execute(
 
             AbsStore ret_store = GetReturnedStore(program, pointsTo, sigma_prime, func, ret_inst->op);
 
-            // for ci, curr_context = func_name
-            std::string curr_context = func->name;
-            if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-                // Popping off from callstring stack is not needed since that is handled by k-limiting the callstring
-                curr_context = curr_cid;
-            }
-
-            call_returned[{func->name, curr_context}] = ret_store;
+            // Popping off from callstring stack is not needed since that is handled by k-limiting the callstring
+            std::set<std::pair<int, int>> callers = state.SetReturned(curr_key, ret_store);
 
-            for (auto it = call_edges[{func->name, curr_context}].begin(); it != call_edges[{func->name, curr_context}].end(); it++) {
+            for (const auto& [callsite, caller_cid] : callers) {
                 
-                std::string caller_bb = it->first.substr(it->first.find(".") + 1);
-                std::string caller_func = it->first.substr(0, it->first.find("."));
-                std::string caller_context = it->second;
+                const auto& [caller_func, caller_bb] = contexts.CallsiteName(callsite);
                 
                 Variable *caller_lhs = nullptr;
                 Instruction *instr = program->funcs[caller_func]->bbs[caller_bb]->terminal;
@@ -727,22 +855,8 @@ void execute(
                 AbsStore caller_store = GetCallerStore(program, ret_store, caller_lhs, program->funcs[caller_func]);
 
                 // Propagate caller store to (func, next_bb)
-                std::string bbs_to_output_key = caller_func + "|" + next_bb;
-                std::string bb2store_key = caller_func;
-                if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-                    bbs_to_output_key = caller_func + "|" + caller_context + "|" + next_bb;
-                    bb2store_key = caller_func + "|" + caller_context;
-                }
-                if (joinAbsStore(bb2store[bb2store_key][next_bb], caller_store) ||
-                    bbs_to_output.count(bbs_to_output_key) == 0)
-                {
-                    bbs_to_output.insert(bbs_to_output_key);
-                    if (sensitivity == 1 || sensitivity == 2 || sensitivity ==3) {
-                        worklist.push_back({caller_func + "|" + caller_context, next_bb});
-                    }
-                    else
-                        worklist.push_back({caller_func, next_bb});
-                }
+                ContextKey caller_key = {contexts.FunctionId(caller_func), caller_cid};
+                state.Propagate(caller_key, next_bb, caller_store);
             }
         }
     }
@@ -760,70 +874,18 @@ void execute(
                 propagate caller_store to bb
         */
 
-        std::string curr_context = func->name + "." + bb->label;
-        if (sensitivity == 0) {
-            // For context insentive, func_name = context_id
-            call_edges[{calldir_inst->callee, calldir_inst->callee}].insert({curr_context, curr_context});
-        }
-        else if (sensitivity == 1 || sensitivity == 2) {
-            /* Add callsite to stack of call-sites which is our context
-             * callsite = func.bb
-            */
-            std::string callee_context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-            /*
-            * For callstring-1 and callstring-2 sensitivity, context_id = callee_context
-            * Map <callee func, callee context> = { set of <caller func, caller context> pairs }
-            */ 
-            call_edges[{calldir_inst->callee, callee_context}].insert({curr_context, curr_cid});
-        }
-        else if (sensitivity == 3) {
-            /*
-            * callee context = get_callee_store(...)
-            */
-            AbsStore callee_store_context = GetCalleeStore(program, pointsTo, sigma_prime, calldir_inst->callee, calldir_inst->args, func);
-            std::string callee_context = GetFunctionalContext(callee_store_context);
-            call_edges[{calldir_inst->callee, callee_context}].insert({curr_context, curr_cid});
-        }
-
+        int callsite = contexts.Callsite(func->name, bb->label);
         AbsStore callee_store = GetCalleeStore(program, pointsTo, sigma_prime, calldir_inst->callee, calldir_inst->args, func);
 
-        std::string bbs_to_output_key = calldir_inst->callee + "|entry";
-        std::string bb2store_key = calldir_inst->callee;
-        if (sensitivity == 1 || sensitivity == 2) {
-            // TODO - Move this callee_context to a common place
-            std::string callee_context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-            bbs_to_output_key = calldir_inst->callee + "|" + callee_context + "|entry";
-            bb2store_key = calldir_inst->callee + "|" + callee_context;
-        }
-        else if (sensitivity == 3) {
-            std::string callee_context = GetFunctionalContext(callee_store);
-            bbs_to_output_key = calldir_inst->callee + "|" + callee_context + "|entry";
-            bb2store_key = calldir_inst->callee + "|" + callee_context;
-        }
-        bool callee_store_changed = joinAbsStore(bb2store[bb2store_key]["entry"], callee_store);
+        /*
+        * Map <callee func, callee context> = { set of <callsite, caller context> pairs }
+        * For context insensitive analysis both contexts are kRoot
+        */
+        int callee = contexts.FunctionId(calldir_inst->callee);
+        ContextKey callee_key = {callee, GetCalleeContext(contexts, sensitivity, callee, callsite, curr_cid, callee_store)};
 
         // Propagate callee store to (<func>, entry), if changed add to worklist
-        if (bbs_to_output.count(bbs_to_output_key) == 0 || callee_store_changed)
-        {
-            bbs_to_output.insert(bbs_to_output_key);
-            if (sensitivity == 1 || sensitivity == 2) {
-                std::string callee_context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-                worklist.push_back({calldir_inst->callee + "|" + callee_context, "entry"});
-            }
-            else if (sensitivity == 3) {
-                std::string callee_context = GetFunctionalContext(callee_store);
-                worklist.push_back({calldir_inst->callee + "|" + callee_context, "entry"});
-            }
-            else if (sensitivity == 0)
-                worklist.push_back({calldir_inst->callee, "entry"});
-        }
-
-        std::string bbs_to_output_key_next = func->name + "|" + calldir_inst->next_bb;
-        bb2store_key = func->name;
-        if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-            bbs_to_output_key_next = func->name + "|" + curr_cid + "|" + calldir_inst->next_bb;
-            bb2store_key = func->name + "|" + curr_cid;
-        }
+        AbsStore returned_store = state.Call(callee_key, callsite, curr_cid, callee_store);
 
         // store[x] = bottom
         if (calldir_inst->lhs) {
@@ -832,47 +894,16 @@ void execute(
         }
 
         // Propagate store to next bb
-        if (joinAbsStore(bb2store[bb2store_key][calldir_inst->next_bb], sigma_prime) ||
-            bbs_to_output.count(bbs_to_output_key_next) == 0)
-        {
-            bbs_to_output.insert(bbs_to_output_key_next);
-            if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-                worklist.push_back({func->name + "|" + curr_cid, calldir_inst->next_bb});
-            }
-            else if (sensitivity == 0)
-                worklist.push_back({func->name, calldir_inst->next_bb});
-        }
+        state.Propagate(curr_key, calldir_inst->next_bb, sigma_prime);
 
         /* if call_returned[<func>] has a ret_store then
          * let caller_store = get_caller_store(call_returned[<func>], x)
          * propagate caller_store to bb
         */
-
-        std::string context = calldir_inst->callee;
-        if (sensitivity == 1 || sensitivity == 2)
-            context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-        else if (sensitivity == 3)
-            context = GetFunctionalContext(callee_store);
-
-        AbsStore returned_store = call_returned[{calldir_inst->callee, context}];
-
         if (returned_store.size() > 0)
         {
             AbsStore caller_store = GetCallerStore(program, returned_store, calldir_inst->lhs, func);
-            
-            std::string bb2store_key = func->name;
-            if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3)
-                bb2store_key = func->name + "|" + curr_cid;
-            if (joinAbsStore(bb2store[bb2store_key][calldir_inst->next_bb], caller_store) ||
-                bbs_to_output.count(bbs_to_output_key_next) == 0)
-            {
-                bbs_to_output.insert(bbs_to_output_key_next);
-                if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3){
-                    worklist.push_back({func->name + "|" + curr_cid, calldir_inst->next_bb});
-                }
-                else if (sensitivity == 0)
-                    worklist.push_back({func->name, calldir_inst->next_bb});
-            }
+            state.Propagate(curr_key, calldir_inst->next_bb, caller_store);
         }
     }
     else if ((*terminal_instruction).instrType == InstructionType::CallIdrInstrType)
@@ -891,107 +922,30 @@ void execute(
                 propagate caller_store to bb
         */
 
-        std::string pointoToKey = isGlobalVar(callidir_inst->fp, program, func->name) ? callidir_inst->fp->name : func->name + "." + callidir_inst->fp->name;
+        std::string pointoToKey = GetKey(program, func, callidir_inst->fp);
+        int callsite = contexts.Callsite(func->name, bb->label);
 
-        for(auto points_to: pointsTo[pointoToKey])
+        for(auto points_to: pointsTo.PointsTo(pointoToKey))
         {
-            std::string curr_context = func->name + "." + bb->label;
-            if (sensitivity == 0) {
-                // For context insentive, func_name = context_id
-                call_edges[{points_to, points_to}].insert({curr_context, curr_context});
-            }
-            else if (sensitivity == 1 || sensitivity == 2) {
-                std::string callee_context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-                call_edges[{points_to, callee_context}].insert({curr_context, curr_cid});
-            }
-            else if (sensitivity == 3) {
-                AbsStore callee_store_context = GetCalleeStore(program, pointsTo, sigma_prime, points_to, callidir_inst->args, func);
-                std::string callee_context = GetFunctionalContext(callee_store_context);
-                call_edges[{points_to, callee_context}].insert({curr_context, curr_cid});
-            }
-
             AbsStore callee_store = GetCalleeStore(program, pointsTo, sigma_prime, points_to, callidir_inst->args, func);
 
-            std::string bb2store_key = points_to;
-            std::string bbs_to_output_key = points_to + "|entry";
-
-            if (sensitivity == 1 || sensitivity == 2) {
-                std::string callee_context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-                bb2store_key = points_to + "|" + callee_context;
-                bbs_to_output_key = points_to + "|" + callee_context + "|entry";
-            }
-            else if (sensitivity == 3) {
-                std::string callee_context = GetFunctionalContext(callee_store);
-                bb2store_key = points_to + "|" + callee_context;
-                bbs_to_output_key = points_to + "|" + callee_context + "|entry";
-            }
-
-            bool callee_store_changed = joinAbsStore(bb2store[bb2store_key]["entry"], callee_store);
+            int callee = contexts.FunctionId(points_to);
+            ContextKey callee_key = {callee, GetCalleeContext(contexts, sensitivity, callee, callsite, curr_cid, callee_store)};
 
             // Propagate callee store to (<func>, entry), if changed add to worklist
-
-            if (bbs_to_output.count(bbs_to_output_key) == 0 || callee_store_changed)
-            {
-                bbs_to_output.insert(bbs_to_output_key);
-                if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-                    std::string callee_context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-                    worklist.push_back({points_to + "|" + callee_context, "entry"});
-                }
-                else if (sensitivity == 3) {
-                    std::string callee_context = GetFunctionalContext(callee_store);
-                    worklist.push_back({points_to + "|" + callee_context, "entry"});
-                }
-                else if (sensitivity == 0)
-                    worklist.push_back({points_to, "entry"});
-            }
+            AbsStore returned_store = state.Call(callee_key, callsite, curr_cid, callee_store);
 
             /* if call_returned[<func>] = ret_store then
              * let caller_store = get_caller_store(ret_store, x)
              * propagate caller_store to bb
             */
-
-            std::string context = points_to;
-            if (sensitivity == 1 || sensitivity == 2)
-                context = AddToCurrentContext(func->name + "." + bb->label, sensitivity, curr_cid);
-            else if (sensitivity == 3)
-                context = GetFunctionalContext(callee_store);
-
-            AbsStore returned_store = call_returned[{points_to, context}];
-
             if (returned_store.size() > 0)
             {
-                std::string bbs_to_output_key_next = func->name + "|" + callidir_inst->next_bb;
-                bb2store_key = func->name;
-                if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-                    bbs_to_output_key_next = func->name + "|" + curr_cid + "|" + callidir_inst->next_bb;
-                    bb2store_key = func->name + "|" + curr_cid;
-                }
-
                 AbsStore caller_store = GetCallerStore(program, returned_store, callidir_inst->lhs, func);
-
-                std::string bb2store_key = func->name;
-                if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3)
-                    bb2store_key = func->name + "|" + curr_cid;
-                if (joinAbsStore(bb2store[bb2store_key][callidir_inst->next_bb], caller_store) ||
-                    bbs_to_output.count(bbs_to_output_key_next) == 0)
-                {
-                    bbs_to_output.insert(bbs_to_output_key_next);
-                    if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3){
-                        worklist.push_back({func->name + "|" + curr_cid, callidir_inst->next_bb});
-                    }
-                    else if (sensitivity == 0)
-                        worklist.push_back({func->name, callidir_inst->next_bb});
-                }
+                state.Propagate(curr_key, callidir_inst->next_bb, caller_store);
             }
         }
 
-        std::string bbs_to_output_key_next = func->name + "|" + callidir_inst->next_bb;
-        std::string bb2store_key = func->name;
-        if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-            bbs_to_output_key_next = func->name + "|" + curr_cid + "|" + callidir_inst->next_bb;
-            bb2store_key = func->name + "|" + curr_cid;
-        }
-
         // store[x] = bottom
         if (callidir_inst->lhs) {
             std::string lhsKey = GetKey(program, func, callidir_inst->lhs);
@@ -999,16 +953,7 @@ void execute(
         }
 
         // Propagate store to next bb
-        if (joinAbsStore(bb2store[bb2store_key][callidir_inst->next_bb], sigma_prime) ||
-            bbs_to_output.count(bbs_to_output_key_next) == 0)
-        {
-            bbs_to_output.insert(bbs_to_output_key_next);
-            if (sensitivity == 1 || sensitivity == 2 || sensitivity == 3) {
-                worklist.push_back({func->name + "|" + curr_cid, callidir_inst->next_bb});
-            }
-            else if (sensitivity == 0)
-                worklist.push_back({func->name, callidir_inst->next_bb});
-        }
+        state.Propagate(curr_key, callidir_inst->next_bb, sigma_prime);
     }
     else
     {
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "./execute_taint.hpp"
+
+/*
+ * Taint fixpoint state for the parallel solver
+ * Every (function, context) has its own block stores and worklist. A context is handed to one worker at a time,
+ * which drains its worklist, so the blocks of a context are still analyzed one after the other; different
+ * contexts run concurrently and only meet through propagated stores, the call edges and the returned stores.
+ * Each of those is guarded by its own lock and no two locks are ever held together.
+ *
+ * Returned stores are joined rather than overwritten, so with every update a join the fixpoint (and with it
+ * soln) doesn't depend on the order workers happen to run in.
+*/
+class ParallelTaintState : public TaintState {
+    public:
+
+    ParallelTaintState(bool sparse) : TaintState(sparse) {}
+
+    void Seed(const ContextKey& key, const std::string& label) override {
+        ContextState* state = GetContextState(key);
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->visited.insert(label);
+            state->worklist.push_back(label);
+            schedule = !state->queued;
+            state->queued = true;
+        }
+        if (schedule)
+            Schedule(key);
+    }
+
+    AbsStore BlockStore(const ContextKey& key, const std::string& label) override {
+        ContextState* state = GetContextState(key);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->bb_stores[label];
+    }
+
+    void Propagate(const ContextKey& key, const std::string& label, const AbsStore& store) override {
+        ContextState* state = GetContextState(key);
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            AbsStore &bb_store = state->bb_stores[label];
+            bool changed = sparse ? joinSparseAbsStore(bb_store, store) : joinAbsStore(bb_store, store);
+            if (changed || state->visited.count(label) == 0) {
+                state->visited.insert(label);
+                state->worklist.push_back(label);
+                schedule = !state->queued;
+                state->queued = true;
+            }
+        }
+        if (schedule)
+            Schedule(key);
+    }
+
+    AbsStore AddCallEdge(const ContextKey& callee_key, int callsite, int caller_cid) override {
+        std::lock_guard<std::mutex> lock(summary_mutex_);
+        return TaintState::AddCallEdge(callee_key, callsite, caller_cid);
+    }
+
+    std::set<std::pair<int, int>> SetReturned(const ContextKey& key, const AbsStore& ret_store) override {
+        std::lock_guard<std::mutex> lock(summary_mutex_);
+        return TaintState::SetReturned(key, ret_store);
+    }
+
+    void AddToSoln(const std::string& sink, const TaintSet& sources) override {
+        std::lock_guard<std::mutex> lock(soln_mutex_);
+        TaintState::AddToSoln(sink, sources);
+    }
+
+    void Log(const std::string& message) override {
+        std::lock_guard<std::mutex> lock(soln_mutex_);
+        TaintState::Log(message);
+    }
+
+    /*
+     * Run the fixpoint on num_threads workers; process(key, label) analyzes one block of a context
+     */
+    template <typename Process>
+    void Solve(int num_threads, Process process) {
+        auto work = [&]() {
+            while (true) {
+                ContextKey key;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex_);
+                    queue_cv_.wait(lock, [&]() { return !ready_.empty() || busy_ == 0; });
+                    if (ready_.empty())
+                        return;
+                    key = ready_.front();
+                    ready_.pop_front();
+                    busy_++;
+                }
+
+                ContextState* state = GetContextState(key);
+                while (true) {
+                    std::string label;
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (state->worklist.empty()) {
+                            state->queued = false;
+                            break;
+                        }
+                        label = state->worklist.front();
+                        state->worklist.pop_front();
+                    }
+                    process(key, label);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(queue_mutex_);
+                    busy_--;
+                    if (busy_ == 0 && ready_.empty())
+                        queue_cv_.notify_all();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < num_threads; t++) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    private:
+
+    struct ContextState {
+        std::mutex mutex;
+        std::map<std::string, AbsStore> bb_stores;
+        std::set<std::string> visited;
+        std::deque<std::string> worklist;
+        bool queued = false; // in the ready queue or being drained by a worker
+    };
+
+    ContextState* GetContextState(const ContextKey& key) {
+        std::lock_guard<std::mutex> lock(states_mutex_);
+        std::unique_ptr<ContextState>& state = states_[key];
+        if (!state)
+            state = std::make_unique<ContextState>();
+        return state.get();
+    }
+
+    void Schedule(const ContextKey& key) {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        ready_.push_back(key);
+        queue_cv_.notify_one();
+    }
+
+    std::mutex states_mutex_;
+    std::map<ContextKey, std::unique_ptr<ContextState>> states_;
+
+    std::mutex summary_mutex_; // call_edges and call_returned
+    std::mutex soln_mutex_;    // soln and log output
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<ContextKey> ready_;
+    int busy_ = 0;
+};
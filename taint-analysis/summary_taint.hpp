@@ -0,0 +1,151 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include "./execute_taint.hpp"
+
+/*
+ * Summary based (IFDS style) taint analysis
+ * Every input of a function - a parameter or an abstract location reachable from the arguments - that some call
+ * taints gets a symbolic source, a marker, numbered after the real sources. The function body is analyzed with
+ * each input tainted by its own marker, which gives its summary: the returned store and the taint reaching each
+ * sink, in terms of real sources and markers. A call applies the callee's summary by replacing every marker with
+ * the caller's taint for that input.
+ *
+ * A body is therefore analyzed once however many contexts call it, and again only when a call taints an input
+ * it hadn't seen or when the summary of one of its callees grows. Taint is propagated per source (joins are
+ * unions and every transfer function treats sources independently), so applying a summary gives the same
+ * result as analyzing the body under the caller's entry store.
+*/
+class SummaryTaintState : public TaintState {
+    public:
+
+    SummaryTaintState(bool sparse) : TaintState(sparse) {}
+
+    AbsStore Call(const ContextKey& callee_key, int /*callsite*/, int /*caller_cid*/, const AbsStore& callee_store) override {
+        int callee_func = callee_key.first;
+        FunctionSummary& callee = summaries_[callee_func];
+        callee.callers.insert(current_);
+        for (const auto& [key, sources] : callee_store) {
+            if (!sources.empty() && callee.inputs.count(key) == 0) {
+                callee.inputs[key] = NewMarker(key);
+                Enqueue(callee_func);
+            }
+        }
+        if (!callee.analyzed)
+            Enqueue(callee_func);
+
+        FunctionSummary& caller = summaries_[current_];
+        for (const auto& [sink, sources] : callee.sinks) {
+            if (joinSets(caller.sinks[sink], Substitute(sources, callee_store)))
+                changed_ = true;
+        }
+
+        AbsStore returned_store;
+        for (const auto& [key, sources] : callee.returned) {
+            returned_store[key] = Substitute(sources, callee_store);
+        }
+        return returned_store;
+    }
+
+    // The summary is applied at the call instead, so there are no callers to return to
+    std::set<std::pair<int, int>> SetReturned(const ContextKey& /*key*/, const AbsStore& ret_store) override {
+        if (joinAbsStore(summaries_[current_].returned, ret_store))
+            changed_ = true;
+        return {};
+    }
+
+    void AddToSoln(const std::string& sink, const TaintSet& sources) override {
+        if (joinSets(summaries_[current_].sinks[sink], sources))
+            changed_ = true;
+    }
+
+    /*
+     * Compute the summaries of main and everything it calls; process(key, label) analyzes one block
+     * soln ends up with the real sources reaching each sink from main.
+     */
+    template <typename Process>
+    void Solve(int main_func, Process process) {
+        Enqueue(main_func);
+        while (!queue_.empty()) {
+            int func = queue_.front();
+            queue_.pop_front();
+            queued_.erase(func);
+
+            current_ = func;
+            changed_ = false;
+            FunctionSummary& summary = summaries_[func];
+
+            // Intraprocedural fixpoint from an entry store tainting every input with its marker
+            bb2store.clear();
+            worklist.clear();
+            bbs_to_output.clear();
+            ContextKey key = {func, ContextTable::kRoot};
+            for (const auto& [input, marker] : summary.inputs) {
+                bb2store[key]["entry"][input] = TaintSet::Of(marker);
+            }
+            Seed(key, "entry");
+            while (!worklist.empty()) {
+                std::pair<ContextKey, std::string> current = worklist.front();
+                worklist.pop_front();
+                process(current.first, current.second);
+            }
+
+            summary.analyzed = true;
+            if (changed_) {
+                for (int caller : summary.callers)
+                    Enqueue(caller);
+            }
+        }
+
+        soln.clear();
+        for (const auto& [sink, sources] : summaries_[main_func].sinks) {
+            soln[sink] = Substitute(sources, {});
+        }
+    }
+
+    private:
+
+    struct FunctionSummary {
+        std::map<std::string, int> inputs; // input key -> marker
+        AbsStore returned;                 // returned store, including FAKE for the return value
+        SolnStore sinks;                   // sink -> sources and markers reaching it
+        std::set<int> callers;
+        bool analyzed = false;
+    };
+
+    int NewMarker(const std::string& key) {
+        marker_keys_.push_back(key);
+        return source_names.size() + marker_keys_.size() - 1;
+    }
+
+    /*
+     * Replace the markers in sources by the taint of the corresponding inputs in actual
+     */
+    TaintSet Substitute(const TaintSet& sources, const AbsStore& actual) {
+        TaintSet result;
+        int num_sources = source_names.size();
+        sources.ForEach([&](int id) {
+            if (id < num_sources) {
+                result.Insert(id);
+                return;
+            }
+            auto it = actual.find(marker_keys_[id - num_sources]);
+            if (it != actual.end())
+                result.Union(it->second);
+        });
+        return result;
+    }
+
+    void Enqueue(int func) {
+        if (queued_.insert(func).second)
+            queue_.push_back(func);
+    }
+
+    std::unordered_map<int, FunctionSummary> summaries_;
+    std::vector<std::string> marker_keys_; // marker - number of sources -> input key
+    std::deque<int> queue_;
+    std::set<int> queued_;
+    int current_ = -1;      // function being analyzed
+    bool changed_ = false;  // the summary of the current function grew
+};
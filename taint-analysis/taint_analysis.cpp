@@ -10,139 +10,218 @@
 #include <deque>
 #include "../headers/datatypes.h"
 #include "./execute_taint.hpp"
+#include "./parallel_taint.hpp"
+#include "./summary_taint.hpp"
+#include "./backward_taint.hpp"
 #include "../headers/tokenizer.hpp"
+#include "../pointer-analysis/points_to_pipeline.hpp"
 
 using json = nlohmann::json;
 
 std::unordered_map<string, std::set<string>> pointsTo; // points to information
+PointsToIndex pointsToIndex; // read-only index over pointsTo shared by the analyses
 
 class TaintAnalysis {
     public:
     
-    TaintAnalysis(Program* program, int sensitivity)
+    TaintAnalysis(Program* program, Sensitivity sensitivity, int k, int max_contexts, bool sparse, int num_threads) : contexts(k, max_contexts)
     {
         this->program = program;
         this->sensitivity = sensitivity;
+        this->sparse = sparse;
+        this->num_threads = num_threads;
     }
 
     void AnalyzeFunction() 
     {
+        // Sparse mode only tracks the keys that can be tainted at all
+        std::unordered_set<std::string> taintable;
+        if (sparse)
+            taintable = ComputeTaintableKeys(program, pointsToIndex);
+
         /*
-        * Worklist now stores the context i.e (func+cid, basic block) pair
+        * The sequential state has a single worklist of ((func, cid), basic block) pairs, the parallel one a worklist
+        * per (func, cid) drained by a pool of workers. The summary state analyzes one function at a time and is
+        * always sequential.
         */
-        std::deque<std::pair<string,string>> worklist;
-        std::map<std::string, std::map<std::string, AbsStore>> bb2store;
-        std::set<std::string> bbs_to_output;
-        std::map<std::string, std::set<std::string>> soln;
-
-        if (sensitivity == 0)
-        {
-            worklist.push_back(std::make_pair("main", "entry"));
-            bbs_to_output.insert("main|entry");
-        }
-        else if (sensitivity == 1 || sensitivity == 2)
-        {
-            worklist.push_back(std::make_pair("main|", "entry"));
-            bbs_to_output.insert("main||entry");
-        }
-        else if (sensitivity == 3)
-        {
-            worklist.push_back(std::make_pair("main|", "entry"));
-            bbs_to_output.insert("main||entry");
-        }
-
-        while(!worklist.empty()) {
-            std::pair<string,string> current = worklist.front();
-            worklist.pop_front();
-            std::string current_func = current.first.substr(0, current.first.find("|"));
-            std::string cid = current.first.substr(current.first.find("|") + 1);
-            std::string current_bb = current.second;
-
-            // Perform the transfer function on the current basic block
+        std::unique_ptr<TaintState> state;
+        if (sensitivity == Sensitivity::Summary)
+            state = std::make_unique<SummaryTaintState>(sparse);
+        else if (num_threads > 0)
+            state = std::make_unique<ParallelTaintState>(sparse);
+        else
+            state = std::make_unique<TaintState>(sparse);
+
+        int main_id = contexts.FunctionId("main");
+        ContextKey main_key = {main_id, contexts.Admit(main_id, ContextTable::kRoot)};
+
+        // Perform the transfer function on a basic block
+        auto process = [&](const ContextKey& key, const std::string& bb_label) {
+            Function *func = program->funcs.at(contexts.FunctionName(key.first));
             execute(
                 program, 
-                program->funcs[current_func], 
-                cid,
-                program->funcs[current_func]->bbs[current_bb], 
-                bb2store, 
-                worklist, 
-                bbs_to_output, 
-                soln, 
-                pointsTo,
-                call_edges,
-                call_returned,
-                sensitivity);
+                func, 
+                key.second,
+                func->bbs.at(bb_label), 
+                *state, 
+                pointsToIndex,
+                contexts,
+                sensitivity,
+                sparse ? &taintable : nullptr);
+        };
+
+        if (sensitivity == Sensitivity::Summary) {
+            ((SummaryTaintState *) state.get())->Solve(main_id, process);
+        }
+        else if (num_threads > 0) {
+            state->Seed(main_key, "entry");
+            ((ParallelTaintState *) state.get())->Solve(num_threads, process);
         }
+        else {
+            state->Seed(main_key, "entry");
+            while(!state->worklist.empty()) {
+                std::pair<ContextKey, string> current = state->worklist.front();
+                state->worklist.pop_front();
+                process(current.first, current.second);
+            }
+        }
+
+        const SolnStore &soln = state->soln;
 
         /*
         * Print soln which will be the sinks to sources that can taint them
         */
         for (auto it = soln.begin(); it != soln.end(); it++) {
-            if (it->second.size() == 0) {
+            if (it->second.empty()) {
                 continue;
             }
             std::cout << it->first << " -> {";
-            for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++) {
-                if (it2 == --it->second.end())
-                    std::cout << *it2;
-                else
-                    std::cout << *it2 << ", ";
-            }
+            PrintTaintSet(it->second, std::cout, ", ");
             std::cout << "}" << std::endl;
         }
         std::cout << std::endl;
     }
 
+    void PrintContextStats() {
+        contexts.PrintStats(std::cerr);
+    }
+
     private:
     
     /*
     * Print call edges
     */
-    void printCallEdges() {
+    void printCallEdges(const TaintState &state) {
         std::cout << "Call edges: " << std::endl;
-        for (auto it = call_edges.begin(); it != call_edges.end(); it++) {
-            std::cout << it->first.first << " : " << it->first.second << " -> {";
+        for (auto it = state.call_edges.begin(); it != state.call_edges.end(); it++) {
+            std::cout << contexts.FunctionName(it->first.first) << " : " << it->first.second << " -> {";
             for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++) {
-                std::cout << it2->first << " : " << it2->second << ",";
+                const auto& [caller_func, caller_bb] = contexts.CallsiteName(it2->first);
+                std::cout << caller_func << "." << caller_bb << " : " << it2->second << ",";
             }
             std::cout << "}" << std::endl;
         }
         std::cout << std::endl;
     }
 
-    // call_edges is a map from (function,cid) -> set of call instructions that call it
-    // For context insensitive analysis, we can ignore the cid part of the key which will be equal to the function name
-    // Maps <func, cid> -> { < set of callsite, cid pairs > }
-    std::map<std::pair<std::string, std::string>, std::set<std::pair<std::string,std::string>>> call_edges;
-    // call_returned is a map from (function,cid) -> returned abstract store
-    // For context insensitive analysis, we can ignore the cid part of the key which will be equal to the function name
-    std::map<std::pair<std::string, std::string>, AbsStore> call_returned;
-    int sensitivity;
+    // Interned functions, callsites and contexts
+    ContextTable contexts;
+    Sensitivity sensitivity;
+    bool sparse;
+    int num_threads; // 0 = sequential solver
     Program *program;
 };
 
-int GetSensitivity(std::string sensitivity) {
+/*
+* Parse ci, callstring-<k> (k >= 1), functional or summary
+*/
+Sensitivity GetSensitivity(std::string sensitivity, int &k) {
+    k = 1;
     if (sensitivity.compare("ci") == 0) {
-        return 0;
+        return Sensitivity::ContextInsensitive;
     }
-    else if (sensitivity.find("callstring") != std::string::npos) {
+    else if (sensitivity.rfind("callstring-", 0) == 0) {
         // If callstring is of the form callstring-k, then k is the sensitivity level
-        std::string k = sensitivity.substr(sensitivity.find("-") + 1);
-        return std::stoi(k);
+        std::string k_str = sensitivity.substr(sensitivity.find("-") + 1);
+        if (!k_str.empty() && k_str.find_first_not_of("0123456789") == std::string::npos) {
+            k = std::stoi(k_str);
+            if (k >= 1)
+                return Sensitivity::Callstring;
+        }
     }
     else if (sensitivity.compare("functional") == 0) {
-        return 3;
+        return Sensitivity::Functional;
     }
-    else {
-        std::cerr << "Invalid sensitivity level" << std::endl;
-        exit(EXIT_FAILURE);
+    else if (sensitivity.compare("summary") == 0) {
+        return Sensitivity::Summary;
     }
+    std::cerr << "Invalid sensitivity level" << std::endl;
+    exit(EXIT_FAILURE);
 }
 
 int main(int argc, char const *argv[])
 {
-    if (argc != 5) {
-        std::cerr << "Usage: taint_analysis <lir file> <lir json filepath> <points to soln file> <sensitivity>" << std::endl;
+    const char* usage = "Usage: taint_analysis <lir file> <lir json filepath> <points to soln file | --solve> <sensitivity> "
+                        "[--max-contexts <n>] [--context-stats] [--sparse] [--threads <n>] [--spec <file>] [--query <func.bb.index | sink>]...";
+    if (argc < 5) {
+        std::cerr << usage << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // --max-contexts caps the contexts per function, merging the rest; --context-stats reports context counts
+    int max_contexts = std::numeric_limits<int>::max();
+    bool context_stats = false;
+    // --sparse only propagates variables that can be tainted by a source
+    bool sparse = false;
+    // --threads solves with a pool of n workers (0 = one per core) instead of the sequential worklist
+    // (summary sensitivity is always solved sequentially)
+    int num_threads = 0;
+    // --spec reads the sources, sinks, sanitizers and propagation rules of externs from a json file
+    std::string spec_file;
+    // --query answers which sources can reach the given sink calls with a backward search instead of the full analysis
+    std::vector<std::string> queries;
+    for (int i = 5; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--max-contexts" && i + 1 < argc) {
+            max_contexts = std::stoi(argv[++i]);
+            if (max_contexts < 1) {
+                std::cerr << "--max-contexts must be at least 1" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (option == "--context-stats") {
+            context_stats = true;
+        }
+        else if (option == "--sparse") {
+            sparse = true;
+        }
+        else if (option == "--threads" && i + 1 < argc) {
+            num_threads = std::stoi(argv[++i]);
+            if (num_threads <= 0)
+                num_threads = std::max(1u, std::thread::hardware_concurrency());
+            pta::num_threads = num_threads;
+        }
+        else if (option == "--spec" && i + 1 < argc) {
+            spec_file = argv[++i];
+        }
+        else if (option == "--query" && i + 1 < argc) {
+            queries.push_back(argv[++i]);
+        }
+        else {
+            std::cerr << usage << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The backward search is context insensitive, a finer sensitivity would be silently ignored
+    if (!queries.empty() && std::string(argv[4]) != "ci") {
+        std::cerr << "--query only supports ci sensitivity" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Contexts are admitted in the order they are reached, which with a pool of workers depends on scheduling
+    if (max_contexts != std::numeric_limits<int>::max() && num_threads > 0) {
+        std::cerr << "--max-contexts cannot be combined with --threads" << std::endl;
         return EXIT_FAILURE;
     }
 
@@ -150,12 +229,17 @@ int main(int argc, char const *argv[])
     json lir_json = json::parse(f);
 
     std::string pointsToFile = argv[3];
-    std::ifstream in(pointsToFile);
-    std::string input_str(std::istreambuf_iterator<char>{in}, {});
+    // With --solve the points-to solution is computed in-process instead of being read from a file
+    bool solve_points_to = pointsToFile == "--solve";
+    std::string input_str;
+    if (!solve_points_to) {
+        std::ifstream in(pointsToFile);
+        input_str.assign(std::istreambuf_iterator<char>{in}, {});
+    }
 
     std::string sensitivity = argv[4];
-    int sens = GetSensitivity(sensitivity);
-    //std::cout << "Sensitivity: " << sens << std::endl;
+    int k;
+    Sensitivity sens = GetSensitivity(sensitivity, k);
 
     util::Tokenizer tk(input_str, {' '}, {"{", "}", "->", ","}, {});
     std::vector<std::string> tokens = tk.Tokens();
@@ -195,9 +279,41 @@ int main(int argc, char const *argv[])
     }
 
     Program program = Program(lir_json);
+    if (solve_points_to) {
+        for (auto const& [name, points_to] : pta::ComputePointsTo(program)) {
+            pointsTo[name] = points_to;
+        }
+    }
+    pointsToIndex = PointsToIndex(pointsTo);
+
+    // Classify the externs once, then number the sources; taint sets are bitsets over the numbered sources
+    if (!spec_file.empty())
+        taint_spec = TaintSpec::FromFile(spec_file);
+    taint_spec.Compile(&program);
+    NumberSources(&program);
+
+    if (!queries.empty()) {
+        BackwardTaintQuery query(&program, pointsToIndex);
+        for (const auto& q : queries) {
+            std::vector<BackwardTaintQuery::SinkCall> calls = query.Resolve(q);
+            if (calls.empty()) {
+                std::cerr << "No call to a sink matches " << q << std::endl;
+                return EXIT_FAILURE;
+            }
+            for (const auto& call : calls) {
+                std::cout << call.site << ": " << call.inst->extFuncName << " -> {";
+                PrintTaintSet(query.Sources(call), std::cout, ", ");
+                std::cout << "}" << std::endl;
+            }
+        }
+        std::cout << std::endl;
+        return 0;
+    }
 
-    TaintAnalysis taint_analysis = TaintAnalysis(&program, sens);
+    TaintAnalysis taint_analysis = TaintAnalysis(&program, sens, k, max_contexts, sparse, num_threads);
     taint_analysis.AnalyzeFunction();
+    if (context_stats)
+        taint_analysis.PrintContextStats();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+ * Set of taint sources as a bitset over the source numbers
+ * The first 64 sources live in an inline word, so the common case of a handful of sources never allocates;
+ * higher sources spill into a heap vector of further words. Union is an in-place OR that reports whether
+ * any bit was added, which is all the fixpoint needs from a join.
+*/
+class TaintSet {
+    public:
+
+    TaintSet() = default;
+
+    static TaintSet Of(int source) {
+        TaintSet set;
+        set.Insert(source);
+        return set;
+    }
+
+    void Insert(int source) {
+        Word(source / 64) |= (uint64_t) 1 << (source % 64);
+    }
+
+    bool Contains(int source) const {
+        int word = source / 64;
+        if (word == 0)
+            return (inline_word_ >> source) & 1;
+        if (word > (int) overflow_.size())
+            return false;
+        return (overflow_[word - 1] >> (source % 64)) & 1;
+    }
+
+    /*
+     * this = this U other, returns true if this changed
+     */
+    bool Union(const TaintSet& other) {
+        uint64_t added = other.inline_word_ & ~inline_word_;
+        inline_word_ |= other.inline_word_;
+        if (other.overflow_.size() > overflow_.size())
+            overflow_.resize(other.overflow_.size(), 0);
+        for (size_t i = 0; i < other.overflow_.size(); i++) {
+            added |= other.overflow_[i] & ~overflow_[i];
+            overflow_[i] |= other.overflow_[i];
+        }
+        return added != 0;
+    }
+
+    bool empty() const {
+        if (inline_word_ != 0)
+            return false;
+        for (uint64_t word : overflow_) {
+            if (word != 0)
+                return false;
+        }
+        return true;
+    }
+
+    size_t size() const {
+        size_t count = __builtin_popcountll(inline_word_);
+        for (uint64_t word : overflow_)
+            count += __builtin_popcountll(word);
+        return count;
+    }
+
+    /*
+     * Call f on every source in increasing order
+     */
+    template <typename F>
+    void ForEach(F f) const {
+        ForEachInWord(inline_word_, 0, f);
+        for (size_t i = 0; i < overflow_.size(); i++)
+            ForEachInWord(overflow_[i], (i + 1) * 64, f);
+    }
+
+    bool operator==(const TaintSet& other) const {
+        if (inline_word_ != other.inline_word_)
+            return false;
+        size_t n = std::max(overflow_.size(), other.overflow_.size());
+        for (size_t i = 0; i < n; i++) {
+            uint64_t a = i < overflow_.size() ? overflow_[i] : 0;
+            uint64_t b = i < other.overflow_.size() ? other.overflow_[i] : 0;
+            if (a != b)
+                return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const TaintSet& other) const { return !(*this == other); }
+
+    // Trailing zero words don't change the hash, matching operator==
+    size_t Hash() const {
+        size_t hash = std::hash<uint64_t>()(inline_word_);
+        size_t zeros = 0;
+        for (uint64_t word : overflow_) {
+            if (word == 0) {
+                zeros++;
+                continue;
+            }
+            for (; zeros > 0; zeros--)
+                hash = hash * 31;
+            hash = hash * 31 + std::hash<uint64_t>()(word);
+        }
+        return hash;
+    }
+
+    private:
+
+    uint64_t& Word(int word) {
+        if (word == 0)
+            return inline_word_;
+        if (word > (int) overflow_.size())
+            overflow_.resize(word, 0);
+        return overflow_[word - 1];
+    }
+
+    template <typename F>
+    static void ForEachInWord(uint64_t word, int base, F& f) {
+        while (word != 0) {
+            int bit = __builtin_ctzll(word);
+            f(base + bit);
+            word &= word - 1;
+        }
+    }
+
+    uint64_t inline_word_ = 0;
+    std::vector<uint64_t> overflow_;
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../headers/datatypes.h"
+
+/*
+ * What the taint analysis does at a call to an extern
+ *  - Source: the result and everything reachable from the arguments are tainted by the extern
+ *  - Sink: the taint of the arguments and of everything reachable from them reaches the extern
+ *  - Sanitizer: the result and everything reachable from the arguments are untainted
+ *  - Other: the result is untainted unless the spec has propagation rules for the extern
+*/
+enum class ExternKind { Other, Source, Sink, Sanitizer };
+
+struct ExternRule {
+    static constexpr int kReturn = -1;
+
+    ExternKind kind = ExternKind::Other;
+    // (from, to): the taint of argument from and of what it reaches flows into the result (to = kReturn) or into
+    // everything reachable from argument to. Only used for Other externs.
+    std::vector<std::pair<int, int>> flows;
+};
+
+/*
+ * Source, sink and sanitizer specification for the taint analysis
+ * The spec file is json of the form
+ *   {
+ *     "sources": ["read_*"],
+ *     "sinks": ["exec", "*snk*"],
+ *     "sanitizers": ["escape_html"],
+ *     "propagators": {"strcpy": [{"from": 1, "to": 0}], "strdup": [{"from": 0, "to": "ret"}]}
+ *   }
+ * where every list is optional and names may contain * wildcards. An extern matching several lists is a source
+ * before a sink before a sanitizer. The default spec makes externs whose name contains src sources and those
+ * whose name contains snk sinks.
+ *
+ * Compile resolves the patterns against the externs of a program once, into a table indexed by
+ * ExternalFunction::id, so classifying a call during the analysis is an array lookup.
+*/
+class TaintSpec {
+    public:
+
+    TaintSpec() : sources_({"*src*"}), sinks_({"*snk*"}) {}
+
+    static TaintSpec FromFile(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Could not open spec file " << path << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        TaintSpec spec;
+        try {
+            json spec_json = json::parse(in);
+            spec.sources_ = ReadPatterns(spec_json, "sources");
+            spec.sinks_ = ReadPatterns(spec_json, "sinks");
+            spec.sanitizers_ = ReadPatterns(spec_json, "sanitizers");
+            if (spec_json.contains("propagators")) {
+                for (auto& [pattern, flows_json] : spec_json["propagators"].items()) {
+                    std::vector<std::pair<int, int>> flows;
+                    for (auto& flow_json : flows_json) {
+                        int from = flow_json.at("from").get<int>();
+                        const json& to_json = flow_json.at("to");
+                        int to = to_json.is_string() && to_json.get<std::string>() == "ret" ? ExternRule::kReturn : to_json.get<int>();
+                        if (from < 0 || to < ExternRule::kReturn) {
+                            std::cerr << "Invalid propagation rule for " << pattern << " in spec file " << path << std::endl;
+                            exit(EXIT_FAILURE);
+                        }
+                        flows.push_back({from, to});
+                    }
+                    spec.propagators_.push_back({pattern, flows});
+                }
+            }
+        }
+        catch (const json::exception& e) {
+            std::cerr << "Invalid spec file " << path << ": " << e.what() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return spec;
+    }
+
+    /*
+     * Classify every extern of program
+     */
+    void Compile(Program* program) {
+        rules_.assign(program->ext_funcs.size(), ExternRule());
+        for (auto [name, ext_func] : program->ext_funcs) {
+            ExternRule& rule = rules_[ext_func->id];
+            if (Matches(sources_, name))
+                rule.kind = ExternKind::Source;
+            else if (Matches(sinks_, name))
+                rule.kind = ExternKind::Sink;
+            else if (Matches(sanitizers_, name))
+                rule.kind = ExternKind::Sanitizer;
+            else {
+                for (const auto& [pattern, flows] : propagators_) {
+                    if (Match(pattern, name))
+                        rule.flows.insert(rule.flows.end(), flows.begin(), flows.end());
+                }
+            }
+        }
+    }
+
+    const ExternRule& Rule(const ExternalFunction* ext_func) const {
+        return rules_[ext_func->id];
+    }
+
+    private:
+
+    static std::vector<std::string> ReadPatterns(const json& spec_json, const char* field) {
+        std::vector<std::string> patterns;
+        if (spec_json.contains(field)) {
+            for (auto& pattern : spec_json[field])
+                patterns.push_back(pattern.get<std::string>());
+        }
+        return patterns;
+    }
+
+    static bool Matches(const std::vector<std::string>& patterns, const std::string& name) {
+        for (const auto& pattern : patterns) {
+            if (Match(pattern, name))
+                return true;
+        }
+        return false;
+    }
+
+    // Glob match where * matches any (possibly empty) substring
+    static bool Match(const std::string& pattern, const std::string& name) {
+        size_t p = 0, n = 0, star = std::string::npos, resume = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                resume = n;
+            }
+            else if (p < pattern.size() && pattern[p] == name[n]) {
+                p++;
+                n++;
+            }
+            else if (star != std::string::npos) {
+                p = star + 1;
+                n = ++resume;
+            }
+            else
+                return false;
+        }
+        while (p < pattern.size() && pattern[p] == '*')
+            p++;
+        return p == pattern.size();
+    }
+
+    std::vector<std::string> sources_;
+    std::vector<std::string> sinks_;
+    std::vector<std::string> sanitizers_;
+    std::vector<std::pair<std::string, std::vector<std::pair<int, int>>>> propagators_;
+
+    std::vector<ExternRule> rules_; // ExternalFunction::id -> rule
+};